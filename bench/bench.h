@@ -0,0 +1,151 @@
+#pragma once
+#include <RPI-GPIO.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+	/**
+	 * Result of a single benchmark
+	 */
+	struct Result {
+		std::string name;       // Benchmark name
+		uint64_t iterations;    // Number of operations timed
+		double ns_per_op;       // Average time per operation, in nanoseconds
+
+		double ops_per_sec() const { return ns_per_op > 0.0 ? 1e9 / ns_per_op : 0.0; }
+	};
+
+	/**
+	 * Collects benchmark results
+	 */
+	struct Report {
+		std::vector<Result> results;
+		std::vector<std::pair<std::string, double>> metrics;   // Other measured values
+
+		/**
+		 * Times a callable
+		 * @param name benchmark name
+		 * @param iterations number of times f is called
+		 * @param f operation to time
+		 */
+		template<typename F>
+		const Result& run(std::string name, uint64_t iterations, F&& f)
+		{
+			using clock = std::chrono::steady_clock;
+			// warm up
+			for (uint64_t i{ 0 }; i < iterations / 10; ++i)
+				f(i);
+			const auto begin{ clock::now() };
+			for (uint64_t i{ 0 }; i < iterations; ++i)
+				f(i);
+			const auto end{ clock::now() };
+			const double ns{ static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()) };
+			return results.emplace_back(Result{ std::move(name), iterations, ns / static_cast<double>(iterations) });
+		}
+
+		/**
+		 * Adds a result measured by the caller
+		 * @param name benchmark name
+		 * @param iterations number of operations
+		 * @param ns total time, in nanoseconds
+		 */
+		const Result& add(std::string name, uint64_t iterations, double ns)
+		{
+			return results.emplace_back(Result{ std::move(name), iterations, iterations ? ns / static_cast<double>(iterations) : 0.0 });
+		}
+
+		/**
+		 * Adds a measured value that isn't a time per operation
+		 * @param name metric name
+		 * @param value metric value
+		 */
+		void metric(std::string name, double value)
+		{
+			metrics.emplace_back(std::move(name), value);
+		}
+
+		/**
+		 * Writes the report as JSON
+		 * @param os output stream
+		 * @param version library version
+		 * @param backend backend name
+		 */
+		void json(std::ostream& os, const std::string& version, const std::string& backend) const
+		{
+			os << "{\n"
+				<< "  \"library\": \"RPI_GPIO\",\n"
+				<< "  \"version\": \"" << version << "\",\n"
+				<< "  \"backend\": \"" << backend << "\",\n"
+				<< "  \"results\": [";
+			for (size_t i{ 0 }; i < results.size(); ++i) {
+				const auto& res{ results[i] };
+				os << (i ? "," : "") << "\n    { \"name\": \"" << res.name << "\", \"iterations\": " << res.iterations
+					<< ", \"ns_per_op\": " << std::fixed << std::setprecision(3) << res.ns_per_op
+					<< ", \"ops_per_sec\": " << std::setprecision(0) << res.ops_per_sec() << " }";
+			}
+			os << "\n  ],\n  \"metrics\": {";
+			for (size_t i{ 0 }; i < metrics.size(); ++i)
+				os << (i ? "," : "") << "\n    \"" << metrics[i].first << "\": " << std::setprecision(3) << metrics[i].second;
+			os << "\n  }\n}\n";
+		}
+
+		friend std::ostream& operator<<(std::ostream& os, const Report& r)
+		{
+			for (const auto& res : r.results)
+				os << std::left << std::setw(40) << res.name
+				<< std::right << std::setw(12) << std::fixed << std::setprecision(2) << res.ns_per_op << " ns/op"
+				<< std::setw(16) << std::setprecision(0) << res.ops_per_sec() << " ops/s" << '\n';
+			for (const auto& [name, value] : r.metrics)
+				os << std::left << std::setw(40) << name
+				<< std::right << std::setw(12) << std::fixed << std::setprecision(2) << value << '\n';
+			return os;
+		}
+	};
+
+	/**
+	 * Reports a suite that feeds input levels to the pins, only the emulated GPIO block
+	 * can be driven that way
+	 * @param suite suite name
+	 */
+	inline void skipUnlessEmulated(const char* suite)
+	{
+		std::cerr << suite << ": skipped, input levels can only be driven on the 'emu' backend" << std::endl;
+	}
+
+	/** Benchmark suites **/
+	template<typename Backend>
+	void primitives(rpigpio::BasicGPIO<Backend>& gpio, Report& report, unsigned int pin);
+	template<typename Backend>
+	void mask(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void pin(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void mode(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void edge(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void waveform(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void softpwm(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void capture(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void remote(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void executor(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void debounce(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void quadrature(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void pulse(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+	template<typename Backend>
+	void spi(rpigpio::BasicGPIO<Backend>& gpio, Report& report);
+}
@@ -0,0 +1,71 @@
+#include "bench.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Maximum sustained capture sample rate, and bytes per recorded change.
+	 * Pins 0-7 of the emulated GPIO block are driven through its external input by a
+	 * stimulus script, changing every 256 emulated cycles (register accesses), the way a
+	 * device wired to the pins would. Skipped on the other backends.
+	 */
+	template<typename Backend>
+	void capture(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		if constexpr (!std::is_same_v<Backend, EmuMem>)
+			skipUnlessEmulated("capture");
+		else {
+			const std::string path{ "/tmp/gpiobench-capture-" + std::to_string(getpid()) + ".bin" };
+			const PinSet pins{ PinSet::fromMask(0xFF) };
+			Bcm2835Emulator& emulator{ *gpio.getBackend().emulator };
+
+			ModeConfig inputs;
+			for (unsigned int pin{ 0 }; pin < 8; ++pin)
+				inputs.set(pin, PIN_MODE::INPUT);
+			gpio.pinMode(inputs);
+
+			std::vector<StimulusStep> script(1 << 18);
+			for (uint64_t i{ 0 }; i < script.size(); ++i)
+				script[i] = StimulusStep{ (i + 1) * 256, pins, PinSet::fromMask((i + 1) & 0xFF) };
+			emulator.script(std::move(script));
+
+			CaptureStats stats;
+			{
+				CaptureWriter out{ path, 1 << 20 };
+				const std::atomic<bool> never{ false };
+				stats = rpigpio::capture(gpio, out, 0xFF, 1000000000, never);
+			}
+			emulator.script({});
+			emulator.release(pins);
+
+			report.add("capture/sample", stats.samples, static_cast<double>(stats.duration));
+			report.add("capture/change", stats.changes, static_cast<double>(stats.duration));
+
+			// decode the file back
+			{
+				CaptureReader reader{ path };
+				volatile uint64_t decoded{ 0 };
+				const auto begin{ monotonicNow() };
+				for (const auto& event : reader)
+					decoded = decoded + event.time;
+				report.add("capture/decode", reader.size(), static_cast<double>(monotonicNow() - begin));
+			}
+
+			report.metric("capture/samples_per_sec", stats.sampleRate());
+			report.metric("capture/bytes_per_change", sizeof(CaptureRecord));
+
+			unlink(path.c_str());
+		}
+	}
+
+	template void capture(GPIO&, Report&);
+	template void capture(GPIOMem&, Report&);
+	template void capture(SimGPIO&, Report&);
+	template void capture(EmuGPIO&, Report&);
+}
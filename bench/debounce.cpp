@@ -0,0 +1,61 @@
+#include "bench.h"
+
+#include <random>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Per-sample cost of the vertical counter Debouncer vs. one counter per pin,
+	 * for 1 to 54 monitored pins fed with bouncing levels
+	 */
+	template<typename Backend>
+	void debounce(BasicGPIO<Backend>&, Report& report)
+	{
+		constexpr uint64_t N{ 1000000 };
+		constexpr unsigned int THRESHOLD{ 5 };
+
+		// each pin holds a level for a while, with short bursts of bounces when it changes
+		std::vector<PinLevels> samples(4096);
+		std::mt19937_64 rng{ 42 };
+		uint64_t levels{ 0 };
+		for (auto& sample : samples) {
+			if (rng() % 16 == 0) levels ^= rng();
+			sample = PinLevels{ (levels ^ (rng() & rng() & rng())) & ((1ull << PIN_COUNT) - 1) };
+		}
+
+		volatile uint64_t sink{ 0 };
+		for (const unsigned int pins : { 1u, 8u, 16u, 32u, 54u }) {
+			const PinSet set{ PinSet::fromMask((1ull << pins) - 1) };
+
+			Debouncer debouncer{ THRESHOLD, set };
+			report.run("debounce/vertical_" + std::to_string(pins), N, [&](uint64_t i) {
+				sink = sink + debouncer.update(samples[i & 4095]).bank0;
+			});
+
+			// one counter and one debounced level per pin
+			uint8_t counters[PIN_COUNT]{};
+			uint64_t stable{ 0 };
+			report.run("debounce/per_pin_" + std::to_string(pins), N, [&](uint64_t i) {
+				const uint64_t sample{ samples[i & 4095].value };
+				uint64_t changed{ 0 };
+				for (unsigned int pin{ 0 }; pin < pins; ++pin) {
+					if (((sample ^ stable) >> pin) & 1) {
+						if (++counters[pin] == THRESHOLD) {
+							counters[pin] = 0;
+							stable ^= 1ull << pin;
+							changed |= 1ull << pin;
+						}
+					}
+					else counters[pin] = 0;
+				}
+				sink = sink + changed;
+			});
+		}
+	}
+
+	template void debounce(GPIO&, Report&);
+	template void debounce(GPIOMem&, Report&);
+	template void debounce(SimGPIO&, Report&);
+	template void debounce(EmuGPIO&, Report&);
+}
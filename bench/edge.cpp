@@ -0,0 +1,62 @@
+#include "bench.h"
+
+#include <type_traits>
+#include <vector>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Sustained EdgeDetector throughput, poller thread to consumer thread.
+	 * On the emulated GPIO block a stimulus script toggles the pins every 64 emulated cycles
+	 * (register accesses). On a plain memory page GPEDSn aren't write-1-to-clear: clearing
+	 * the harvested pins leaves their bits set, so every poll finds an event and the engine
+	 * runs flat out. On hardware, events only come from the wired signals: the throughput
+	 * is skipped when none arrived.
+	 */
+	template<typename Backend>
+	void edge(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		using clock = std::chrono::steady_clock;
+		const PinSet pins{ 4, 17, 27, 40 };
+
+		if constexpr (std::is_same_v<Backend, EmuMem>) {
+			gpio.pinMode(ModeConfig{}.set(4, PIN_MODE::INPUT).set(17, PIN_MODE::INPUT).set(27, PIN_MODE::INPUT).set(40, PIN_MODE::INPUT));
+			std::vector<StimulusStep> script(1 << 20);
+			for (uint64_t i{ 0 }; i < script.size(); ++i)
+				script[i] = StimulusStep{ (i + 1) * 64, pins, (i & 1) ? PinSet{} : pins };
+			gpio.getBackend().emulator->script(std::move(script));
+		}
+
+		gpio.edgeDetect(pins, EDGE_DETECT::RISING);
+		EdgeDetector detector{ gpio, pins, 1 << 16 };
+
+		EdgeEvent batch[256];
+		uint64_t events{ 0 };
+		detector.start();
+		const auto begin{ clock::now() };
+		while (clock::now() - begin < std::chrono::seconds{ 1 })
+			events += detector.drain(batch, std::size(batch));
+		const auto end{ clock::now() };
+		detector.stop();
+		events += detector.drain(batch, std::size(batch));
+		gpio.edgeDetect(pins, EDGE_DETECT::RISING, false);
+		if constexpr (std::is_same_v<Backend, EmuMem>) {
+			gpio.getBackend().emulator->script({});
+			gpio.getBackend().emulator->release(pins);
+		}
+
+		const double ns{ static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()) };
+		if (events)
+			report.add("edge/consumed", events, ns);
+		else
+			std::cerr << "edge/consumed: skipped, no edge on pins 4, 17, 27 and 40" << std::endl;
+		report.add("edge/polled", detector.pollCount(), ns);
+		report.metric("edge/dropped", static_cast<double>(detector.dropped()));
+	}
+
+	template void edge(GPIO&, Report&);
+	template void edge(GPIOMem&, Report&);
+	template void edge(SimGPIO&, Report&);
+	template void edge(EmuGPIO&, Report&);
+}
@@ -0,0 +1,55 @@
+#include "bench.h"
+
+#include <thread>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Command queue throughput from 1 to N producer threads, each one writing its own pin,
+	 * and the round trip of a queued read.
+	 */
+	template<typename Backend>
+	void executor(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		const unsigned int maxProducers{ std::max(4u, std::thread::hardware_concurrency()) };
+		constexpr uint64_t N{ 200000 };   // writes per producer
+
+		for (unsigned int producers{ 1 }; producers <= maxProducers; producers *= 2) {
+			GpioExecutor<Backend> exec{ gpio };
+			exec.start();
+
+			std::vector<std::thread> threads;
+			const auto begin{ monotonicNow() };
+			for (unsigned int t{ 0 }; t < producers; ++t) {
+				threads.emplace_back([&exec, t] {
+					const PinSet pin{ 20 + t % 8 };
+					for (uint64_t i{ 0 }; i < N; ++i)
+						exec.write(i & 1 ? pin : PinSet{}, i & 1 ? PinSet{} : pin);
+					exec.sync().wait();
+				});
+			}
+			for (auto& thread : threads)
+				thread.join();
+			const auto end{ monotonicNow() };
+
+			const std::string name{ "executor/write_" + std::to_string(producers) + "p" };
+			report.add(name, N * producers, static_cast<double>(end - begin));
+			// writes merged into each GPSET/GPCLR flush
+			report.metric(name + "_merge", static_cast<double>(exec.commandCount()) / static_cast<double>(exec.flushCount()));
+			exec.stop();
+		}
+
+		GpioExecutor<Backend> exec{ gpio, 4096, std::chrono::nanoseconds{ 0 } };
+		exec.start();
+		report.run("executor/read", 20000, [&](uint64_t) { exec.read().get(); });
+		report.run("executor/mode", 20000, [&](uint64_t i) { exec.pinMode(20, i & 1 ? PIN_MODE::OUTPUT : PIN_MODE::INPUT); });
+		exec.stop();
+		gpio.pinMode(20, PIN_MODE::INPUT);
+	}
+
+	template void executor(GPIO&, Report&);
+	template void executor(GPIOMem&, Report&);
+	template void executor(SimGPIO&, Report&);
+	template void executor(EmuGPIO&, Report&);
+}
@@ -0,0 +1,31 @@
+#!/bin/bash
+# Compares N separate gpiocli invocations with one '--batch' run of the same commands.
+# Runs against a register image file, so no hardware is needed.
+# USAGE: gpiocli-batch.sh <PATH_TO_GPIOCLI> [<N>]
+
+GPIOCLI="${1:?USAGE: $0 <PATH_TO_GPIOCLI> [<N>]}"
+N="${2:-1000}"
+IMAGE="$(mktemp)"
+BATCH="$(mktemp)"
+trap 'rm -f "$IMAGE" "$BATCH"' EXIT
+
+for ((i = 0; i < N; ++i)); do
+	if ((i % 2)); then echo "clear 17"; else echo "set 17"; fi
+	echo "get 17"
+done > "$BATCH"
+
+now() { date +%s%N; }
+
+start=$(now)
+for ((i = 0; i < N; ++i)); do
+	if ((i % 2)); then "$GPIOCLI" -q --image "$IMAGE" -O 17 -Q 17; else "$GPIOCLI" -q --image "$IMAGE" -I 17 -Q 17; fi
+done > /dev/null
+separate=$(($(now) - start))
+
+start=$(now)
+"$GPIOCLI" -q --image "$IMAGE" --batch "$BATCH" > /dev/null
+batch=$(($(now) - start))
+
+echo "separate: $((separate / 1000000)) ms ($((separate / N)) ns/op)"
+echo "batch:    $((batch / 1000000)) ms ($((batch / N)) ns/op)"
+echo "speedup:  $((separate / (batch > 0 ? batch : 1)))x"
@@ -0,0 +1,122 @@
+#include "bench.h"
+
+#include <cstring>
+#include <sstream>
+
+using namespace rpigpio;
+
+#ifndef RPI_GPIO_VERSION
+#define RPI_GPIO_VERSION "0.0.0"
+#endif
+
+struct Help {
+	friend std::ostream& operator<<(std::ostream& os, const Help&)
+	{
+		return os
+			<< "USAGE:\n"
+			<< "  gpiobench [OPTIONS]" << '\n'
+			<< '\n'
+			<< "OPTIONS:\n"
+			<< "  -h, --help                  Show this help display, then exit." << '\n'
+			<< "  -b, --backend '<NAME>'      Register page to benchmark: 'sim' (in-memory, default), 'emu' (emulated GPIO block), 'gpiomem' or 'mem' (hardware)." << '\n'
+			<< "  -s, --suites '<LIST>'       Comma-separated list of suites to run. (Default: all)" << '\n'
+			<< "  -p, --pin '<#>'             Pin written by the primitive benchmarks. (Default: 27)" << '\n'
+			<< "  -j, --json                  Print the results as JSON." << '\n'
+			<< '\n'
+			<< "SUITES:\n"
+			<< "  primitives, mask, pin, mode, edge, waveform, softpwm, capture, remote, executor, debounce, quadrature, pulse, spi" << '\n'
+			<< '\n'
+			<< "  Hardware backends drive the benchmark pins and reset pins 2 to 27!" << '\n'
+			;
+	}
+};
+
+struct Options {
+	std::string backend{ "sim" };
+	std::vector<std::string> suites;
+	unsigned int pin{ 27 };
+	bool json{ false };
+
+	bool selected(const std::string& suite) const
+	{
+		return suites.empty() || std::find(suites.begin(), suites.end(), suite) != suites.end();
+	}
+};
+
+template<typename Backend>
+void RunSuites(const Options& opt, bench::Report& report)
+{
+	BasicGPIO<Backend> gpio{};
+	gpio.connect();
+
+	if (opt.selected("primitives")) bench::primitives(gpio, report, opt.pin);
+	if (opt.selected("mask")) bench::mask(gpio, report);
+	if (opt.selected("pin")) bench::pin(gpio, report);
+	if (opt.selected("mode")) bench::mode(gpio, report);
+	if (opt.selected("edge")) bench::edge(gpio, report);
+	if (opt.selected("waveform")) bench::waveform(gpio, report);
+	if (opt.selected("softpwm")) bench::softpwm(gpio, report);
+	if (opt.selected("capture")) bench::capture(gpio, report);
+	if (opt.selected("remote")) bench::remote(gpio, report);
+	if (opt.selected("executor")) bench::executor(gpio, report);
+	if (opt.selected("debounce")) bench::debounce(gpio, report);
+	if (opt.selected("quadrature")) bench::quadrature(gpio, report);
+	if (opt.selected("pulse")) bench::pulse(gpio, report);
+	if (opt.selected("spi")) bench::spi(gpio, report);
+}
+
+int main(const int argc, char** argv)
+{
+	try {
+		Options opt;
+		for (int i{ 1 }; i < argc; ++i) {
+			const std::string arg{ argv[i] };
+			const auto& next{ [&]() -> std::string {
+				if (i + 1 >= argc) throw std::invalid_argument{ "Missing value for '" + arg + "'!" };
+				return argv[++i];
+			} };
+
+			if (arg == "-h" || arg == "--help") {
+				std::cout << Help();
+				return 0;
+			}
+			else if (arg == "-b" || arg == "--backend")
+				opt.backend = next();
+			else if (arg == "-s" || arg == "--suites") {
+				std::stringstream ss{ next() };
+				for (std::string suite; std::getline(ss, suite, ',');)
+					opt.suites.push_back(suite);
+			}
+			else if (arg == "-p" || arg == "--pin") {
+				opt.pin = static_cast<unsigned int>(std::stoul(next()));
+				if (opt.pin >= PIN_COUNT) throw std::invalid_argument{ "Invalid Pin Number: '" + std::to_string(opt.pin) + "'" };
+			}
+			else if (arg == "-j" || arg == "--json")
+				opt.json = true;
+			else throw std::invalid_argument{ "Unknown argument: '" + arg + "'" };
+		}
+
+		bench::Report report;
+		if (opt.backend == "sim")
+			RunSuites<AnonMem>(opt, report);
+		else if (opt.backend == "emu")
+			RunSuites<EmuMem>(opt, report);
+		else if (opt.backend == "gpiomem")
+			RunSuites<GpioMem>(opt, report);
+		else if (opt.backend == "mem")
+			RunSuites<DevMem>(opt, report);
+		else throw std::invalid_argument{ "Unknown backend: '" + opt.backend + "'" };
+
+		if (opt.json)
+			report.json(std::cout, RPI_GPIO_VERSION, opt.backend);
+		else
+			std::cout << report;
+		return 0;
+	} catch (const std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "An undefined exception occurred!" << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,45 @@
+#include "bench.h"
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Applies a 16-pin output frame, one digitalWrite per pin vs. a single writeMask
+	 */
+	template<typename Backend>
+	void mask(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		constexpr unsigned int pins[]{ 2, 3, 4, 5, 6, 7, 8, 9, 40, 41, 42, 43, 44, 45, 46, 47 };
+		constexpr uint64_t N{ 1000000 };
+
+		// precomputed frames, alternating pin levels
+		PinSet all, even;
+		for (unsigned int p{ 0 }; p < std::size(pins); ++p) {
+			all.add(pins[p]);
+			if (p % 2 == 0)
+				even.add(pins[p]);
+		}
+		const PinSet odd{ ~even & all };
+
+		report.run("frame16/digitalWrite", N, [&](uint64_t i) {
+			for (unsigned int p{ 0 }; p < std::size(pins); ++p)
+				gpio.digitalWrite(pins[p], ((i + p) & 1) != 0);
+		});
+
+		report.run("frame16/writeFrame", N, [&](uint64_t i) {
+			gpio.writeFrame(all, (i & 1) ? odd : even);
+		});
+
+		report.run("frame16/writeMask", N, [&](uint64_t i) {
+			if (i & 1)
+				gpio.writeMask(odd.bank0, even.bank0, odd.bank1, even.bank1);
+			else
+				gpio.writeMask(even.bank0, odd.bank0, even.bank1, odd.bank1);
+		});
+	}
+
+	template void mask(GPIO&, Report&);
+	template void mask(GPIOMem&, Report&);
+	template void mask(SimGPIO&, Report&);
+	template void mask(EmuGPIO&, Report&);
+}
@@ -0,0 +1,69 @@
+#include "bench.h"
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Configures 20 pins one by one vs. as a single ModeConfig, with and without the GPFSEL shadow.
+	 * Same for pulls, half of the pins pulled up and half pulled down. The pins are reset
+	 * to INPUT without pull afterwards.
+	 */
+	template<typename Backend>
+	void mode(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		constexpr uint64_t N{ 100000 };
+
+		ModeConfig config;
+		for (unsigned int pin{ 2 }; pin < 22; ++pin)
+			config.set(pin, PIN_MODE::OUTPUT);
+
+		report.run("mode20/pinMode", N, [&](uint64_t) {
+			for (unsigned int pin{ 2 }; pin < 22; ++pin)
+				gpio.pinMode(pin, PIN_MODE::OUTPUT);
+		});
+
+		report.run("mode20/ModeConfig", N, [&](uint64_t) {
+			gpio.pinMode(config);
+		});
+
+		gpio.setModeShadow(true);
+		report.run("mode20/ModeConfig+shadow", N, [&](uint64_t) {
+			gpio.pinMode(config);
+		});
+
+		unsigned int sum{ 0 };
+		report.run("getMode/shadow", N * 100, [&](uint64_t i) {
+			sum += gpio.getMode(i % PIN_COUNT);
+		});
+		gpio.setModeShadow(false);
+
+		report.run("getMode", N * 100, [&](uint64_t i) {
+			sum += gpio.getMode(i % PIN_COUNT);
+		});
+
+		PullConfig pulls;
+		for (unsigned int pin{ 2 }; pin < 22; ++pin)
+			pulls.set(pin, pin & 1 ? PULL_MODE::DOWN : PULL_MODE::UP);
+
+		report.run("pull20/pinPull", N / 100, [&](uint64_t) {
+			for (unsigned int pin{ 2 }; pin < 22; ++pin)
+				gpio.pinPull(pin, pin & 1 ? PULL_MODE::DOWN : PULL_MODE::UP);
+		});
+
+		report.run("pull20/PullConfig", N / 100, [&](uint64_t) {
+			gpio.pinPull(pulls);
+		});
+
+		// leave the pins as found: INPUT, without pull
+		gpio.reset();
+		PullConfig off;
+		for (unsigned int pin{ 2 }; pin < 22; ++pin)
+			off.set(pin, PULL_MODE::OFF);
+		gpio.pinPull(off);
+	}
+
+	template void mode(GPIO&, Report&);
+	template void mode(GPIOMem&, Report&);
+	template void mode(SimGPIO&, Report&);
+	template void mode(EmuGPIO&, Report&);
+}
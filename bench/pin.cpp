@@ -0,0 +1,39 @@
+#include "bench.h"
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Toggles a fixed pin through the runtime and compile-time pin APIs
+	 */
+	template<typename Backend>
+	void pin(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		constexpr uint64_t N{ 10000000 };
+
+		report.run("toggle/digitalWrite", N, [&](uint64_t i) {
+			gpio.digitalWrite(17, (i & 1) != 0);
+		});
+
+		const auto out{ gpio.template pin<17>() };
+		report.run("toggle/Pin<17>::write", N, [&](uint64_t i) {
+			out.write((i & 1) != 0);
+		});
+
+		auto led{ gpio.template output<17>() };
+		report.run("toggle/OutputPin<17>::toggle", N, [&](uint64_t) {
+			led.toggle();
+		});
+
+		const auto in{ gpio.template pin<4>() };
+		uint64_t highs{ 0 };
+		report.run("read/Pin<4>::read", N, [&](uint64_t) {
+			highs += in.read();
+		});
+	}
+
+	template void pin(GPIO&, Report&);
+	template void pin(GPIOMem&, Report&);
+	template void pin(SimGPIO&, Report&);
+	template void pin(EmuGPIO&, Report&);
+}
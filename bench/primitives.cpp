@@ -0,0 +1,58 @@
+#include "bench.h"
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Every single-pin GPIO primitive, on the benchmark pin
+	 */
+	template<typename Backend>
+	void primitives(BasicGPIO<Backend>& gpio, Report& report, unsigned int pin)
+	{
+		constexpr uint64_t N{ 10000000 };
+
+		gpio.pinMode(pin, PIN_MODE::OUTPUT);
+
+		report.run("primitive/pinUp", N, [&](uint64_t) {
+			gpio.pinUp(pin);
+		});
+		report.run("primitive/pinDown", N, [&](uint64_t) {
+			gpio.pinDown(pin);
+		});
+		report.run("primitive/digitalWrite", N, [&](uint64_t i) {
+			gpio.digitalWrite(pin, (i & 1) != 0);
+		});
+
+		unsigned int sum{ 0 };
+		report.run("primitive/pinLev", N, [&](uint64_t) {
+			sum += gpio.pinLev(pin);
+		});
+		report.run("primitive/digitalRead", N, [&](uint64_t) {
+			sum += gpio.digitalRead(pin);
+		});
+		report.run("primitive/readAll", N, [&](uint64_t) {
+			sum += static_cast<unsigned int>(gpio.readAll().value);
+		});
+
+		report.run("primitive/pinMode", N / 10, [&](uint64_t i) {
+			gpio.pinMode(pin, (i & 1) ? PIN_MODE::OUTPUT : PIN_MODE::INPUT);
+		});
+		report.run("primitive/reset", N / 10, [&](uint64_t) {
+			gpio.reset();
+		});
+
+		// shared backends reuse the mapping of gpio, the others map a page every time
+		report.run("primitive/connect+disconnect", 10000, [&](uint64_t) {
+			BasicGPIO<Backend> other;
+			other.connect();
+			other.disconnect();
+		});
+
+		gpio.pinMode(pin, PIN_MODE::INPUT);
+	}
+
+	template void primitives(GPIO&, Report&, unsigned int);
+	template void primitives(GPIOMem&, Report&, unsigned int);
+	template void primitives(SimGPIO&, Report&, unsigned int);
+	template void primitives(EmuGPIO&, Report&, unsigned int);
+}
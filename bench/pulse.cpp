@@ -0,0 +1,73 @@
+#include "bench.h"
+
+#include <type_traits>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Tick cost vs. number of channels, and the resulting maximum trackable frequency.
+	 * The pins of the emulated GPIO block are driven through its external input: every
+	 * channel toggles on every tick, the worst case, so a tick rate R tracks signals up to
+	 * R/2 Hz. The tick cost includes driving the inputs. The pulse counts tell whether
+	 * edges were lost. Skipped on the other backends.
+	 */
+	template<typename Backend>
+	void pulse(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		if constexpr (!std::is_same_v<Backend, EmuMem>)
+			skipUnlessEmulated("pulse");
+		else {
+			Bcm2835Emulator& emulator{ *gpio.getBackend().emulator };
+			const PinSet all{ PinSet::fromMask((1ull << PIN_COUNT) - 1) };
+
+			ModeConfig inputs;
+			for (unsigned int pin{ 0 }; pin < PIN_COUNT; ++pin)
+				inputs.set(pin, PIN_MODE::INPUT);
+			gpio.pinMode(inputs);
+
+			constexpr uint64_t N{ 1000000 };
+
+			for (const unsigned int channels : { 1u, 2u, 4u, 8u, 12u, 16u, 32u, 54u }) {
+				emulator.drive(all, {});
+				PulseCounter<EmuMem> counter{ gpio };
+				for (unsigned int c{ 0 }; c < channels; ++c)
+					counter.add(c);
+				const PinSet pins{ PinSet::fromMask((1ull << channels) - 1) };
+
+				// HIGH on even ticks, the level follows the number of ticks, which carries over from the warm up
+				const auto& result{ report.run("pulse/tick_" + std::to_string(channels), N, [&](uint64_t) {
+					emulator.drive(pins, (counter.tickCount() & 1) ? PinSet{} : pins);
+					counter.tick();
+				}) };
+
+				// one rising edge every two ticks, on every channel
+				const uint64_t expected{ (counter.tickCount() + 1) / 2 };
+				uint64_t lost{ 0 };
+				for (unsigned int c{ 0 }; c < channels; ++c) {
+					const uint64_t pulses{ counter.stats(c).pulses };
+					lost += pulses > expected ? pulses - expected : expected - pulses;
+				}
+				report.metric("pulse/max_hz_" + std::to_string(channels), result.ops_per_sec() / 2);
+				report.metric("pulse/lost_pulses_" + std::to_string(channels), static_cast<double>(lost));
+			}
+
+			// ticks without change only compare the snapshot
+			{
+				emulator.drive(all, {});
+				PulseCounter<EmuMem> counter{ gpio };
+				for (unsigned int c{ 0 }; c < 12; ++c)
+					counter.add(c);
+				report.run("pulse/tick_idle_12", N, [&](uint64_t) { counter.tick(); });
+				report.run("pulse/stats", N, [&](uint64_t i) { (void)counter.stats(static_cast<unsigned int>(i % 12)); });
+			}
+
+			emulator.release(all);
+		}
+	}
+
+	template void pulse(GPIO&, Report&);
+	template void pulse(GPIOMem&, Report&);
+	template void pulse(SimGPIO&, Report&);
+	template void pulse(EmuGPIO&, Report&);
+}
@@ -0,0 +1,70 @@
+#include "bench.h"
+
+#include <type_traits>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Decoding cost per tick vs. number of encoders, and the resulting maximum step rate.
+	 * The emulated GPIO block is fed with synthetic quadrature waveforms through its
+	 * external input, one snapshot per tick: every encoder moves by one step on every
+	 * tick, in its own direction, so the final positions tell whether steps were lost.
+	 * The tick cost includes driving the inputs. Skipped on the other backends.
+	 */
+	template<typename Backend>
+	void quadrature(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		if constexpr (!std::is_same_v<Backend, EmuMem>)
+			skipUnlessEmulated("quadrature");
+		else {
+			Bcm2835Emulator& emulator{ *gpio.getBackend().emulator };
+
+			constexpr unsigned int SEQUENCE[4]{ 0b00, 0b10, 0b11, 0b01 };  // A leads B
+			constexpr uint64_t N{ 1000000 };
+
+			for (const unsigned int encoders : { 1u, 2u, 4u, 8u, 16u, 27u }) {
+				const PinSet pins{ PinSet::fromMask((1ull << (2 * encoders)) - 1) };
+				ModeConfig inputs;
+				for (unsigned int pin{ 0 }; pin < 2 * encoders; ++pin)
+					inputs.set(pin, PIN_MODE::INPUT);
+				gpio.pinMode(inputs);
+				emulator.drive(pins, {});
+
+				QuadratureDecoder<EmuMem> decoder{ gpio };
+				for (unsigned int e{ 0 }; e < encoders; ++e)
+					decoder.add(2 * e, 2 * e + 1);
+
+				// one snapshot per phase, odd encoders turn backwards
+				PinSet snapshots[4];
+				for (unsigned int phase{ 0 }; phase < 4; ++phase) {
+					uint64_t levels{ 0 };
+					for (unsigned int e{ 0 }; e < encoders; ++e)
+						levels |= static_cast<uint64_t>(SEQUENCE[e & 1 ? (4 - phase) % 4 : phase]) << (2 * e);
+					snapshots[phase] = PinSet::fromMask(levels);
+				}
+
+				// the phase follows the number of ticks, which carries over from the warm up
+				const auto& result{ report.run("quadrature/tick_" + std::to_string(encoders), N, [&](uint64_t) {
+					emulator.drive(pins, snapshots[(decoder.tickCount() + 1) % 4]);
+					decoder.tick();
+				}) };
+
+				// every tick stepped every encoder
+				const int64_t expected{ static_cast<int64_t>(decoder.tickCount()) };
+				uint64_t lost{ 0 };
+				for (unsigned int e{ 0 }; e < encoders; ++e)
+					lost += static_cast<uint64_t>(std::llabs(std::llabs(decoder.position(e)) - expected)) + decoder.errors(e);
+				report.metric("quadrature/max_steps_per_sec_" + std::to_string(encoders), result.ops_per_sec());
+				report.metric("quadrature/lost_steps_" + std::to_string(encoders), static_cast<double>(lost));
+
+				emulator.release(pins);
+			}
+		}
+	}
+
+	template void quadrature(GPIO&, Report&);
+	template void quadrature(GPIOMem&, Report&);
+	template void quadrature(SimGPIO&, Report&);
+	template void quadrature(EmuGPIO&, Report&);
+}
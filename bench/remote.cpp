@@ -0,0 +1,64 @@
+#include "bench.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Round-trip latency and throughput of the remote access protocol.
+	 * The server runs in a thread of this process and serves the benchmarked register page.
+	 */
+	template<typename Backend>
+	void remote(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		const std::string path{ "/tmp/gpiobench-remote-" + std::to_string(getpid()) + ".sock" };
+		RemoteServer server{ path };
+		std::atomic<bool> stop{ false };
+		std::thread thread{ [&] { server.serve(gpio, stop); } };
+
+		RemoteClient client;
+		if (!client.connect(path))
+			throw std::runtime_error{ "Failed to connect to '" + path + "'!" };
+
+		const PinSet pins{ 20, 21 };
+		report.run("remote/readAll", 20000, [&](uint64_t) { client.readAll(); });
+		report.run("remote/write", 20000, [&](uint64_t i) { client.write(i & 1 ? pins : PinSet{}, i & 1 ? PinSet{} : pins); });
+
+		// a full request, counted per op
+		RemoteRequest req;
+		RemoteResponse resp;
+		for (uint32_t i{ 0 }; i < REMOTE_MAX_OPS; ++i)
+			i & 1 ? req.read() : req.write(pins, PinSet{});
+		const uint64_t requests{ 20000 };
+		const auto begin{ monotonicNow() };
+		for (uint64_t i{ 0 }; i < requests; ++i)
+			client.transact(req, resp);
+		report.add("remote/batched_op", requests * REMOTE_MAX_OPS, static_cast<double>(monotonicNow() - begin));
+
+		// round-trip latency distribution
+		std::vector<int64_t> latencies;
+		latencies.reserve(requests);
+		for (uint64_t i{ 0 }; i < requests; ++i) {
+			const auto start{ monotonicNow() };
+			client.readAll();
+			latencies.push_back(static_cast<int64_t>(monotonicNow() - start));
+		}
+		const auto& stats{ PlaybackStats::compute(latencies) };
+		report.metric("remote/rtt_p50_ns", static_cast<double>(stats.p50));
+		report.metric("remote/rtt_p99_ns", static_cast<double>(stats.p99));
+		report.metric("remote/rtt_max_ns", static_cast<double>(stats.max));
+
+		client.disconnect();
+		stop.store(true);
+		thread.join();
+	}
+
+	template void remote(GPIO&, Report&);
+	template void remote(GPIOMem&, Report&);
+	template void remote(SimGPIO&, Report&);
+	template void remote(EmuGPIO&, Report&);
+}
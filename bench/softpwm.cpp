@@ -0,0 +1,46 @@
+#include "bench.h"
+
+#include <thread>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * SoftPwm schedule rebuild cost and achieved period rate with 1, 8 and 54 channels
+	 */
+	template<typename Backend>
+	void softpwm(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		for (unsigned int count : { 1u, 8u, 54u }) {
+			PinSet channels;
+			uint32_t duties[PIN_COUNT]{};
+			for (unsigned int pin{ 0 }; pin < count; ++pin) {
+				channels.add(pin);
+				duties[pin] = (pin * 37) % 101;
+			}
+
+			PwmSchedule schedule;
+			report.run("softpwm/build/" + std::to_string(count), 100000, [&](uint64_t) {
+				schedule.build(channels, duties, 100);
+			});
+
+			// 10kHz, 100 steps
+			SoftPwm pwm{ gpio, 100000, 100 };
+			pwm.calibrate();
+			for (unsigned int pin{ 0 }; pin < count; ++pin)
+				pwm.enable(pin, duties[pin]);
+
+			const auto begin{ monotonicNow() };
+			pwm.start();
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 500 });
+			pwm.stop();
+			report.add("softpwm/period/" + std::to_string(count), pwm.periodCount(), static_cast<double>(monotonicNow() - begin));
+			report.metric("softpwm/overruns/" + std::to_string(count), static_cast<double>(pwm.overrunCount()));
+		}
+	}
+
+	template void softpwm(GPIO&, Report&);
+	template void softpwm(GPIOMem&, Report&);
+	template void softpwm(SimGPIO&, Report&);
+	template void softpwm(EmuGPIO&, Report&);
+}
@@ -0,0 +1,35 @@
+#include "bench.h"
+
+#include <vector>
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Unpaced bit-banged SPI throughput on large buffers, write-only and full-duplex.
+	 * Uses the hardware SPI0 pins: CS 8, SCLK 11, MOSI 10, MISO 9.
+	 */
+	template<typename Backend>
+	void spi(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		const SpiMaster<Backend> master{ gpio, SpiConfig{ 8, 11, 10, 9 } };
+
+		for (const size_t size : { size_t{ 4096 }, size_t{ 65536 } }) {
+			std::vector<uint8_t> tx(size), rx(size);
+			for (size_t i{ 0 }; i < size; ++i)
+				tx[i] = static_cast<uint8_t>(i * 37);
+
+			const std::string suffix{ "_" + std::to_string(size / 1024) + "k" };
+			const uint64_t transfers{ (1u << 20) / size + 1 };
+			const auto& write{ report.run("spi/write" + suffix, transfers, [&](uint64_t) { master.write(tx.data(), size); }) };
+			report.metric("spi/write" + suffix + "_mb_per_sec", static_cast<double>(size) * write.ops_per_sec() / 1e6);
+			const auto& duplex{ report.run("spi/transfer" + suffix, transfers, [&](uint64_t) { master.transfer(tx.data(), rx.data(), size); }) };
+			report.metric("spi/transfer" + suffix + "_mb_per_sec", static_cast<double>(size) * duplex.ops_per_sec() / 1e6);
+		}
+	}
+
+	template void spi(GPIO&, Report&);
+	template void spi(GPIOMem&, Report&);
+	template void spi(SimGPIO&, Report&);
+	template void spi(EmuGPIO&, Report&);
+}
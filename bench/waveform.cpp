@@ -0,0 +1,39 @@
+#include "bench.h"
+
+using namespace rpigpio;
+
+namespace bench {
+	/**
+	 * Plays a 4-pin pattern with a 50us step and reports the edge placement deviation
+	 */
+	template<typename Backend>
+	void waveform(BasicGPIO<Backend>& gpio, Report& report)
+	{
+		constexpr uint64_t STEPS{ 2000 }, PERIOD{ 50000 };
+
+		Waveform wave;
+		for (uint64_t i{ 0 }; i < STEPS; ++i) {
+			const PinSet high{ PinSet{}.add(static_cast<unsigned int>(17 + i % 4)) };
+			wave.add(i * PERIOD, high, ~high & PinSet{ 17, 18, 19, 20 });
+		}
+		wave.compile();
+
+		WaveformPlayer player;
+		player.calibrate();
+
+		const auto begin{ monotonicNow() };
+		const auto stats{ player.play(gpio, wave) };
+		report.add("waveform/frame", stats.frames, static_cast<double>(monotonicNow() - begin));
+		report.metric("waveform/spin_window_ns", static_cast<double>(player.spinWindow()));
+		report.metric("waveform/deviation_min_ns", static_cast<double>(stats.min));
+		report.metric("waveform/deviation_mean_ns", stats.mean);
+		report.metric("waveform/deviation_p50_ns", static_cast<double>(stats.p50));
+		report.metric("waveform/deviation_p99_ns", static_cast<double>(stats.p99));
+		report.metric("waveform/deviation_max_ns", static_cast<double>(stats.max));
+	}
+
+	template void waveform(GPIO&, Report&);
+	template void waveform(GPIOMem&, Report&);
+	template void waveform(SimGPIO&, Report&);
+	template void waveform(EmuGPIO&, Report&);
+}
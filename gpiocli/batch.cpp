@@ -0,0 +1,138 @@
+#include "batch.h"
+
+#include <ParamsAPI2.hpp>
+
+#include <sstream>
+
+std::optional<rpigpio::PIN_MODE> StringToPinMode(const std::string& mode)
+{
+	std::string modestr{ str::strip(str::tolower(mode), " \t\r\n\v") };
+
+	if (str::equalsAny(modestr, "i", "in", "input"))
+		return rpigpio::PIN_MODE::INPUT;
+	else if (str::equalsAny(modestr, "o", "out", "output"))
+		return rpigpio::PIN_MODE::OUTPUT;
+	else if (str::equalsAny(modestr, "0", "alt0"))
+		return rpigpio::PIN_MODE::ALT0;
+	else if (str::equalsAny(modestr, "1", "alt1"))
+		return rpigpio::PIN_MODE::ALT1;
+	else if (str::equalsAny(modestr, "2", "alt2"))
+		return rpigpio::PIN_MODE::ALT2;
+	else if (str::equalsAny(modestr, "3", "alt3"))
+		return rpigpio::PIN_MODE::ALT3;
+	else if (str::equalsAny(modestr, "4", "alt4"))
+		return rpigpio::PIN_MODE::ALT4;
+	else if (str::equalsAny(modestr, "5", "alt5"))
+		return rpigpio::PIN_MODE::ALT5;
+	return std::nullopt;
+}
+
+std::optional<rpigpio::PULL_MODE> StringToPullMode(const std::string& pull)
+{
+	std::string pullstr{ str::strip(str::tolower(pull), " \t\r\n\v") };
+
+	if (str::equalsAny(pullstr, "u", "up"))
+		return rpigpio::PULL_MODE::UP;
+	else if (str::equalsAny(pullstr, "d", "down"))
+		return rpigpio::PULL_MODE::DOWN;
+	else if (str::equalsAny(pullstr, "o", "off", "none"))
+		return rpigpio::PULL_MODE::OFF;
+	return std::nullopt;
+}
+
+/**
+ * Parses a pin number, throws when invalid
+ */
+static unsigned int ParsePin(const std::string& s, size_t number)
+{
+	const auto& pin{ str::optional::stoui(s) };
+	if (!pin.has_value() || pin.value() >= rpigpio::PIN_COUNT)
+		throw make_exception("Line ", number, ": Invalid Pin Number: '", s, "'");
+	return pin.value();
+}
+
+/**
+ * Parses a duration with an optional us/ms/s suffix (milliseconds by default), throws when invalid
+ */
+static uint64_t ParseDuration(const std::string& s, size_t number)
+{
+	size_t end{ 0 };
+	uint64_t value{ 0 };
+	try {
+		value = std::stoull(s, &end);
+	} catch (...) {
+		throw make_exception("Line ", number, ": Invalid Duration: '", s, "'");
+	}
+
+	const std::string unit{ s.substr(end) };
+	if (unit.empty() || unit == "ms") return value * 1000000ull;
+	else if (unit == "us") return value * 1000ull;
+	else if (unit == "s") return value * 1000000000ull;
+	throw make_exception("Line ", number, ": Invalid Duration: '", s, "'");
+}
+
+BatchCommand BatchCommand::parse(const std::string& line, size_t number)
+{
+	BatchCommand cmd;
+
+	std::istringstream ss{ line.substr(0, line.find('#')) };
+	std::vector<std::string> words;
+	for (std::string word; ss >> word;) {
+		// pin lists can also be comma-separated
+		std::istringstream ws{ word };
+		for (std::string part; std::getline(ws, part, ',');)
+			if (!part.empty())
+				words.push_back(part);
+	}
+	if (words.empty()) return cmd;
+
+	const std::string name{ str::tolower(words.front()) };
+	const size_t argc{ words.size() - 1 };
+
+	if (str::equalsAny(name, "set", "high", "on", "clear", "low", "off")) {
+		cmd.op = str::equalsAny(name, "set", "high", "on") ? Op::SET : Op::CLEAR;
+		for (size_t i{ 1 }; i < words.size(); ++i)
+			cmd.pins.add(ParsePin(words[i], number));
+	}
+	else if (name == "mode") {
+		cmd.op = Op::MODE;
+		for (size_t i{ 1 }; i < words.size(); ++i) {
+			auto [pinstr, modestr] { str::split(words[i], ':') };
+			// also accept "mode <#> <MODE>"
+			if (modestr.empty() && i + 1 < words.size())
+				modestr = words[++i];
+			const auto& mode{ StringToPinMode(modestr) };
+			if (!mode.has_value())
+				throw make_exception("Line ", number, ": Invalid Mode: '", modestr, "'");
+			cmd.modes.set(ParsePin(pinstr, number), mode.value());
+		}
+	}
+	else if (name == "get") {
+		cmd.op = Op::GET;
+		for (size_t i{ 1 }; i < words.size(); ++i)
+			cmd.order.push_back(ParsePin(words[i], number));
+	}
+	else if (name == "sleep") {
+		if (argc != 1)
+			throw make_exception("Line ", number, ": Usage: sleep <N>[us|ms|s]");
+		cmd.op = Op::SLEEP;
+		cmd.ns = ParseDuration(words[1], number);
+	}
+	else if (name == "wait") {
+		if (argc < 2 || argc > 3 || (words[2] != "0" && words[2] != "1"))
+			throw make_exception("Line ", number, ": Usage: wait <#> <0|1> [<MS>]");
+		cmd.op = Op::WAIT;
+		cmd.order.push_back(ParsePin(words[1], number));
+		cmd.level = words[2] == "1";
+		if (argc == 3)
+			cmd.ns = ParseDuration(words[3], number);
+	}
+	else if (name == "reset") {
+		cmd.op = Op::RESET;
+	}
+	else throw make_exception("Line ", number, ": Unknown Command: '", words.front(), "'");
+
+	if (argc == 0 && cmd.op != Op::RESET)
+		throw make_exception("Line ", number, ": Missing Arguments for '", words.front(), "'");
+	return cmd;
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <RPI-GPIO.h>
+
+#include <make_exception.hpp>
+
+#include <cstdio>
+#include <istream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Converts a mode name to a pin mode
+ * @param mode mode name, case insensitive
+ * @return the pin mode, or std::nullopt when invalid
+ */
+std::optional<rpigpio::PIN_MODE> StringToPinMode(const std::string& mode);
+
+/**
+ * Converts a pull name to a pull value
+ * @param pull pull name, case insensitive
+ * @return the pull value, or std::nullopt when invalid
+ */
+std::optional<rpigpio::PULL_MODE> StringToPullMode(const std::string& pull);
+
+/**
+ * One parsed line of a batch file
+ */
+struct BatchCommand {
+	enum class Op : char {
+		NONE,   // Empty line or comment
+		SET,
+		CLEAR,
+		MODE,
+		GET,
+		SLEEP,
+		WAIT,
+		RESET,
+	};
+
+	Op op{ Op::NONE };
+	rpigpio::PinSet pins;               // SET, CLEAR
+	std::vector<unsigned int> order;    // GET, WAIT: pins in the order they were given
+	rpigpio::ModeConfig modes;          // MODE
+	uint64_t ns{ 0 };                   // SLEEP: duration, WAIT: timeout (0 for none)
+	bool level{ false };                // WAIT: awaited level
+
+	/**
+	 * Parses a batch line
+	 * @param line line contents
+	 * @param number line number, for error messages
+	 * @return the command, throws on syntax errors
+	 */
+	static BatchCommand parse(const std::string& line, size_t number);
+};
+
+/**
+ * Runs batch commands over one GPIO connection.
+ * Adjacent set/clear commands are merged into one mask write and adjacent mode
+ * commands into one ModeConfig. Output is buffered and written before sleeping,
+ * waiting, and at the end.
+ * @param gpio connected GPIO handler
+ * @param in command stream
+ * @param quiet print values only
+ * @return number of commands executed
+ */
+template<typename Backend>
+size_t RunBatch(const rpigpio::BasicGPIO<Backend>& gpio, std::istream& in, const bool quiet)
+{
+	std::string output;
+	rpigpio::PinSet high, low;
+	rpigpio::ModeConfig modes;
+	bool pendingModes{ false };
+
+	const auto& flushWrites{ [&]() {
+		if (high.empty() && low.empty()) return;
+		gpio.write(high, low);
+		high = low = rpigpio::PinSet{};
+	} };
+	const auto& flushModes{ [&]() {
+		if (!pendingModes) return;
+		gpio.pinMode(modes);
+		modes = rpigpio::ModeConfig{};
+		pendingModes = false;
+	} };
+	const auto& flushOutput{ [&]() {
+		fwrite(output.data(), 1, output.size(), stdout);
+		fflush(stdout);
+		output.clear();
+	} };
+
+	size_t count{ 0 }, number{ 0 };
+	for (std::string line; std::getline(in, line);) {
+		const auto& cmd{ BatchCommand::parse(line, ++number) };
+		if (cmd.op == BatchCommand::Op::NONE) continue;
+		++count;
+
+		if (cmd.op != BatchCommand::Op::MODE) flushModes();
+		if (cmd.op != BatchCommand::Op::SET && cmd.op != BatchCommand::Op::CLEAR) flushWrites();
+
+		switch (cmd.op) {
+		case BatchCommand::Op::SET:
+			// the last write of a pin wins
+			high = high | cmd.pins;
+			low = low & ~cmd.pins;
+			break;
+		case BatchCommand::Op::CLEAR:
+			low = low | cmd.pins;
+			high = high & ~cmd.pins;
+			break;
+		case BatchCommand::Op::MODE:
+			for (unsigned int rnum = 0; rnum < 6; ++rnum) {
+				modes.mask[rnum] |= cmd.modes.mask[rnum];
+				modes.value[rnum] = (modes.value[rnum] & ~cmd.modes.mask[rnum]) | cmd.modes.value[rnum];
+			}
+			pendingModes = true;
+			break;
+		case BatchCommand::Op::GET: {
+			const auto& levels{ gpio.readAll() };
+			for (const auto& pin : cmd.order) {
+				if (!quiet) output += std::to_string(pin) + " = ";
+				output += levels[pin] ? "1\n" : "0\n";
+			}
+			if (output.size() >= 65536) flushOutput();
+			break;
+		}
+		case BatchCommand::Op::SLEEP:
+			flushOutput();
+			std::this_thread::sleep_for(std::chrono::nanoseconds{ cmd.ns });
+			break;
+		case BatchCommand::Op::WAIT: {
+			flushOutput();
+			const uint64_t deadline{ cmd.ns ? rpigpio::monotonicNow() + cmd.ns : 0 };
+			while (gpio.pinLev(cmd.order.front()) != static_cast<unsigned int>(cmd.level)) {
+				if (deadline && rpigpio::monotonicNow() >= deadline)
+					throw make_exception("Line ", number, ": Timed out waiting for pin ", cmd.order.front(), '!');
+				std::this_thread::sleep_for(std::chrono::microseconds{ 10 });
+			}
+			break;
+		}
+		case BatchCommand::Op::RESET:
+			gpio.reset();
+			break;
+		default:
+			break;
+		}
+	}
+
+	flushModes();
+	flushWrites();
+	flushOutput();
+	return count;
+}
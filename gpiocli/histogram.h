@@ -0,0 +1,64 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+/**
+ * HDR-style latency histogram: values below 64 get a bucket each, every following power of
+ * two is split into 32 linear buckets, so the relative error stays under about 3% from
+ * nanoseconds to seconds.
+ */
+struct LatencyHistogram {
+	static constexpr unsigned int LINEAR{ 64 };     // Values with a bucket each
+	static constexpr unsigned int SUB_BITS{ 5 };    // log2 of the number of buckets per power of two
+	static constexpr unsigned int BUCKETS{ LINEAR + (64 - 6) * (1u << SUB_BITS) };
+
+	std::vector<uint64_t> counts = std::vector<uint64_t>(BUCKETS);
+	uint64_t samples{ 0 };
+	uint64_t min{ UINT64_MAX };
+	uint64_t max{ 0 };
+
+	static unsigned int bucket(const uint64_t value)
+	{
+		if (value < LINEAR) return static_cast<unsigned int>(value);
+		const unsigned int exponent{ static_cast<unsigned int>(std::bit_width(value)) - 1 };
+		const unsigned int shift{ exponent - SUB_BITS };
+		return LINEAR + (exponent - 6) * (1u << SUB_BITS) + static_cast<unsigned int>((value >> shift) - (1u << SUB_BITS));
+	}
+
+	/**
+	 * @return largest value counted in a bucket
+	 */
+	static uint64_t upper(const unsigned int index)
+	{
+		if (index < LINEAR) return index;
+		const unsigned int exponent{ (index - LINEAR) / (1u << SUB_BITS) + 6 };
+		const unsigned int shift{ exponent - SUB_BITS };
+		const uint64_t sub{ (index - LINEAR) % (1u << SUB_BITS) };
+		return (((1ull << SUB_BITS) + sub + 1) << shift) - 1;
+	}
+
+	void add(const uint64_t value)
+	{
+		++counts[bucket(value)];
+		++samples;
+		if (value < min) min = value;
+		if (value > max) max = value;
+	}
+
+	/**
+	 * @param p percentile, from 0 to 100
+	 * @return upper bound of the percentile bucket, at most the largest value
+	 */
+	uint64_t percentile(const double p) const
+	{
+		if (samples == 0) return 0;
+		const auto target{ static_cast<uint64_t>(static_cast<double>(samples - 1) * p / 100.0) };
+		uint64_t seen{ 0 };
+		for (unsigned int index{ 0 }; index < BUCKETS; ++index) {
+			seen += counts[index];
+			if (seen > target) return upper(index) < max ? upper(index) : max;
+		}
+		return max;
+	}
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include "histogram.h"
+
+#include <RPI-GPIO.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+
+#include <time.h>
+
+/**
+ * Jitter measurement results
+ */
+struct JitterStats {
+	LatencyHistogram wakeup;    // Wakeup time minus scheduled time
+	LatencyHistogram access;    // Duration of the GPIO read done at each wakeup
+	uint64_t overruns{ 0 };     // Periods missed because a wakeup came later than the next deadline
+};
+
+/**
+ * Runs a fixed-period loop that sleeps until absolute deadlines and reads the pins at each
+ * wakeup. The wakeup latency measures the OS (timer, scheduler, page faults), the read
+ * duration measures the register access itself.
+ * @param gpio connected GPIO handler
+ * @param period loop period in nanoseconds
+ * @param duration measurement duration in nanoseconds, 0 to run until stop is set
+ * @param stop set to true to stop measuring
+ * @return jitter statistics
+ */
+template<typename Backend>
+JitterStats RunJitter(const rpigpio::BasicGPIO<Backend>& gpio, const uint64_t period, const uint64_t duration, const std::atomic<bool>& stop)
+{
+	JitterStats stats;
+	const uint64_t begin{ rpigpio::monotonicNow() };
+	const uint64_t end{ duration ? begin + duration : UINT64_MAX };
+	for (uint64_t deadline{ begin + period }; deadline < end && !stop.load(std::memory_order_relaxed); deadline += period) {
+		const timespec ts{ static_cast<time_t>(deadline / 1000000000ull), static_cast<long>(deadline % 1000000000ull) };
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR && !stop.load(std::memory_order_relaxed)) {}
+
+		const uint64_t woke{ rpigpio::monotonicNow() };
+		(void)gpio.readAll();
+		const uint64_t done{ rpigpio::monotonicNow() };
+		stats.wakeup.add(woke > deadline ? woke - deadline : 0);
+		stats.access.add(done - woke);
+
+		// skip the deadlines that already passed instead of running them back to back
+		if (done >= deadline + period) {
+			const uint64_t missed{ (done - deadline) / period };
+			stats.overruns += missed;
+			deadline += missed * period;
+		}
+	}
+	return stats;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "histogram.h"
+
+#include <RPI-GPIO.h>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+/**
+ * Write methods compared by the loopback measurement
+ */
+enum class LoopbackMethod : unsigned int {
+	DIGITAL_WRITE,  // BasicGPIO::digitalWrite
+	WRITE_MASK,     // BasicGPIO::write with a prebuilt PinSet
+	PIN,            // Compile-time Pin<N>
+	COUNT,
+};
+
+inline const char* LoopbackMethodName(const LoopbackMethod method)
+{
+	static constexpr const char* names[]{ "digitalWrite", "writeMask", "Pin<N>" };
+	return names[static_cast<unsigned int>(method)];
+}
+
+/**
+ * Round trips of one write method
+ */
+struct LoopbackResult {
+	LatencyHistogram round_trip;    // Time from the write to the input reading the new level, in nanoseconds
+	uint64_t timeouts{ 0 };         // Transitions the input never followed
+};
+
+/**
+ * Toggles the output and spins on GPLEV until the input follows, once per iteration
+ * @param gpio connected GPIO handler, the output pin is in OUTPUT mode and the input pin in INPUT mode
+ * @param in input pin number
+ * @param iterations number of transitions
+ * @param timeout longest wait for the input, in nanoseconds
+ * @param write writes a level to the output pin
+ * @param result round trip histogram to fill
+ */
+template<typename Backend, typename Write>
+void MeasureLoopback(const rpigpio::BasicGPIO<Backend>& gpio, const unsigned int in, const uint64_t iterations, const uint64_t timeout, Write&& write, LoopbackResult& result)
+{
+	// start from a known level
+	write(false);
+	for (const uint64_t start{ rpigpio::monotonicNow() }; gpio.pinLev(in) && rpigpio::monotonicNow() - start < timeout;) {}
+
+	bool level{ false };
+	for (uint64_t i{ 0 }; i < iterations; ++i) {
+		level = !level;
+		const uint64_t start{ rpigpio::monotonicNow() };
+		write(level);
+
+		// checking the clock costs more than a load, only do it every 64 spins
+		bool followed{ true };
+		for (unsigned int spins{ 1 }; static_cast<bool>(gpio.pinLev(in)) != level; ++spins) {
+			if (spins % 64 == 0 && rpigpio::monotonicNow() - start >= timeout) {
+				followed = false;
+				break;
+			}
+		}
+		const uint64_t end{ rpigpio::monotonicNow() };
+
+		if (followed)
+			result.round_trip.add(end - start);
+		else if (++result.timeouts; result.round_trip.samples == 0)
+			return;     // nothing is wired, don't wait for every iteration
+	}
+}
+
+/**
+ * MeasureLoopback through Pin<N>, so the output register and mask are constants
+ */
+template<typename Backend, unsigned int N>
+void MeasurePinLoopback(const rpigpio::BasicGPIO<Backend>& gpio, const unsigned int in, const uint64_t iterations, const uint64_t timeout, LoopbackResult& result)
+{
+	const rpigpio::Pin<N, Backend> pin{ gpio };
+	MeasureLoopback(gpio, in, iterations, timeout, [&pin](const bool level) { pin.write(level); }, result);
+}
+
+template<typename Backend, unsigned int... N>
+constexpr auto MakePinLoopbacks(std::integer_sequence<unsigned int, N...>)
+{
+	return std::array{ &MeasurePinLoopback<Backend, N>... };
+}
+
+/**
+ * Measures the output to input round trip of each write method, the output pin must be wired to the input pin
+ * @param gpio connected GPIO handler
+ * @param out output pin number
+ * @param in input pin number
+ * @param iterations number of transitions per method
+ * @param timeout longest wait for the input, in nanoseconds
+ * @return one result per LoopbackMethod
+ */
+template<typename Backend>
+std::array<LoopbackResult, static_cast<unsigned int>(LoopbackMethod::COUNT)> RunLoopback(const rpigpio::BasicGPIO<Backend>& gpio, const unsigned int out, const unsigned int in, const uint64_t iterations, const uint64_t timeout)
+{
+	static constexpr auto pins{ MakePinLoopbacks<Backend>(std::make_integer_sequence<unsigned int, rpigpio::PIN_COUNT>{}) };
+
+	gpio.pinMode(rpigpio::ModeConfig{}.set(out, rpigpio::PIN_MODE::OUTPUT).set(in, rpigpio::PIN_MODE::INPUT));
+
+	std::array<LoopbackResult, static_cast<unsigned int>(LoopbackMethod::COUNT)> results;
+	MeasureLoopback(gpio, in, iterations, timeout, [&gpio, out](const bool level) { gpio.digitalWrite(out, level); }, results[static_cast<unsigned int>(LoopbackMethod::DIGITAL_WRITE)]);
+
+	const rpigpio::PinSet mask{ out };
+	MeasureLoopback(gpio, in, iterations, timeout, [&gpio, &mask](const bool level) { level ? gpio.write(mask, {}) : gpio.write({}, mask); }, results[static_cast<unsigned int>(LoopbackMethod::WRITE_MASK)]);
+
+	pins[out](gpio, in, iterations, timeout, results[static_cast<unsigned int>(LoopbackMethod::PIN)]);
+
+	gpio.pinDown(out);
+	return results;
+}
@@ -1,10 +1,21 @@
 #include "rsc/version.h"
+#include "batch.h"
+#include "watch.h"
+#include "jitter.h"
+#include "loopback.h"
 
 #include <ParamsAPI2.hpp>
 #include <TermAPI.hpp>
 
 #include <RPI-GPIO.h>
 
+#include <atomic>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+
 #define PROGRAM_NAME "gpiocli"
 
 struct Help {
@@ -37,137 +48,465 @@ struct Help {
 			<< "                               | ALT3   | ?           |" << '\n'
 			<< "                               | ALT4   | ?           |" << '\n'
 			<< "                               | ALT5   | ?           |" << '\n'
+			<< "  -p, --pull '<<#>:<PULL>>'   Sets the pull-up/down of pin '<#>' to '<PULL>', which can be 'UP', 'DOWN' or 'OFF'." << '\n'
+			<< "  --capture '<MASK>'          Capture the level changes of the pins in '<MASK>' (bit n is pin n) to the file given by '--out'." << '\n'
+			<< "  --out '<FILE>'              Capture output file." << '\n'
+			<< "  --duration '<MS>'           Capture, watch and jitter duration in milliseconds. They run until interrupted when omitted." << '\n'
+			<< "  --records '<#>'             Number of changes kept in the capture file, older ones are overwritten," << '\n'
+			<< "                               or number of writes kept by '--record'. (Default: 1048576)" << '\n'
+			<< "  --watch '<#>,...'           Print the level changes of the specified pins, one '<TIMESTAMP_NS> <#> <0|1>' line each." << '\n'
+			<< "                               A summary with the number of dropped and coalesced events is printed to STDERR." << '\n'
+			<< "  --interval '<US>'           Watch poll interval in microseconds, 0 to busy poll. Lower values use more CPU. (Default: 1000)" << '\n'
+			<< "  --binary                    Write watched changes as 16-byte records (u64 timestamp, u32 pin, u32 level)." << '\n'
+			<< "  --jitter '<US>'             Run a loop with a period of '<US>' microseconds in real-time conditions, then print the" << '\n'
+			<< "                               wakeup latency and pin read duration percentiles. Runs for '--duration' or until interrupted." << '\n'
+			<< "  --loopback '<OUT>:<IN>'     Toggle pin '<OUT>', wired to pin '<IN>', and print the percentiles of the time until '<IN>'" << '\n'
+			<< "                               reads the new level, in nanoseconds, for each write method. With '--sim' the pins are" << '\n'
+			<< "                               wired in the emulator." << '\n'
+			<< "  --iterations '<#>'          Number of transitions per write method of '--loopback'. (Default: 10000)" << '\n'
+			<< "  --cpu '<#>'                 CPU the jitter and loopback loops are pinned to. (Default: first isolated CPU, if any)" << '\n'
+			<< "  --priority '<#>'            SCHED_FIFO priority of the jitter and loopback loops, 0 keeps the normal scheduler. (Default: 50)" << '\n'
+			<< "  --batch '<FILE>'            Run the commands of '<FILE>' over a single connection, '-' or no file reads stdin." << '\n'
+			<< "                               Commands, one per line, '#' starts a comment:" << '\n'
+			<< "                               | set <#>...            | Set pins to HIGH                                |" << '\n'
+			<< "                               | clear <#>...          | Set pins to LOW                                 |" << '\n'
+			<< "                               | mode <#>:<MODE>...    | Set pin modes                                   |" << '\n'
+			<< "                               | get <#>...            | Print pin states, from one snapshot             |" << '\n'
+			<< "                               | sleep <N>[us|ms|s]    | Sleep, milliseconds by default                  |" << '\n'
+			<< "                               | wait <#> <0|1> [<MS>] | Wait for a pin state, fails after <MS> if given |" << '\n'
+			<< "                               | reset                 | Reset GPIO state                                |" << '\n'
+			<< "                               Adjacent set/clear and adjacent mode commands are applied together." << '\n'
+			<< "  --record '<FILE>'           Record every GPFSEL, GPSET and GPCLR write of all the steps to the trace file '<FILE>'." << '\n'
+			<< "                               Requires a build with RPI_GPIO_ENABLE_TRACE." << '\n'
+			<< "  --replay '<FILE>'           Replay the writes of the trace file '<FILE>' with their original timing." << '\n'
+			<< "  --diff '<A>,<B>'            Compare the pin activity of two trace files, then exit. Exits with 1 when they differ." << '\n'
+			<< "  --window '<US>'             Writes closer than '<US>' microseconds are compared as one change. (Default: 0)" << '\n'
+			<< "  --tolerance '<US>'          Largest accepted time difference between identical changes, in microseconds." << '\n'
+			<< "  --daemon '<SOCKET>'         Serve remote pin access requests on the Unix socket '<SOCKET>' until interrupted." << '\n'
+			<< "  --socket-mode '<OCTAL>'     Permissions of the daemon socket. (Default: 0660)" << '\n'
+			<< "  --image '<FILE>'            Use a register image file instead of the GPIO peripheral, for testing." << '\n'
+			<< "  --sim                       Use an emulated GPIO block instead of the GPIO peripheral, for testing." << '\n'
+			<< "  --stats                     Print register access counters and method latencies before exiting." << '\n'
+			<< "                               Requires a library built with RPI_GPIO_ENABLE_STATS." << '\n'
 			<< '\n'
 			<< "ORDER OF OPERATIONS:\n"
 			<< "  Steps are only executed if the associated operation was specified." << '\n'
 			<< "   1.  Reset GPIO state" << '\n'
-			<< "   2.  Set specified pin mode(s)" << '\n'
+			<< "   2.  Set specified pin mode(s) and pull(s)" << '\n'
 			<< "   3.  Set specified pin(s) to high" << '\n'
 			<< "   4.  Set specified pin(s) to low" << '\n'
 			<< "   5.  Query specified pin state(s)" << '\n'
+			<< "   6.  Run batch commands" << '\n'
+			<< "   7.  Replay trace" << '\n'
+			<< "   8.  Capture" << '\n'
+			<< "   9.  Watch" << '\n'
+			<< "  10.  Measure jitter" << '\n'
+			<< "  11.  Measure loopback latency" << '\n'
+			<< "  12.  Serve remote requests" << '\n'
+			<< "  13.  Save the recorded trace" << '\n'
 			;
 	}
 };
 
 using pin_t = unsigned int;
 
-inline std::optional<rpigpio::PIN_MODE> StringToPinMode(const std::string& mode)
+enum class Color : char {
+	PIN,
+	VALUE,
+};
+
+static std::atomic<bool> interrupted{ false };
+
+inline void OnInterrupt(int)
 {
-	std::string modestr{ str::strip(str::tolower(mode), " \t\r\n\v") };
-
-	if (str::equalsAny(modestr, "i", "in", "input"))
-		return rpigpio::PIN_MODE::INPUT;
-	else if (str::equalsAny(modestr, "o", "out", "output"))
-		return rpigpio::PIN_MODE::OUTPUT;
-	else if (str::equalsAny(modestr, "0", "alt0"))
-		return rpigpio::PIN_MODE::ALT0;
-	else if (str::equalsAny(modestr, "1", "alt1"))
-		return rpigpio::PIN_MODE::ALT1;
-	else if (str::equalsAny(modestr, "2", "alt2"))
-		return rpigpio::PIN_MODE::ALT2;
-	else if (str::equalsAny(modestr, "3", "alt3"))
-		return rpigpio::PIN_MODE::ALT3;
-	else if (str::equalsAny(modestr, "4", "alt4"))
-		return rpigpio::PIN_MODE::ALT4;
-	else if (str::equalsAny(modestr, "5", "alt5"))
-		return rpigpio::PIN_MODE::ALT5;
-	return std::nullopt;
+	interrupted.store(true);
 }
 
-int main(const int argc, char** argv)
+/**
+ * @return real-time settings of the measurement loops, from '--cpu' and '--priority'
+ */
+rpigpio::RealtimeConfig GetRealtimeConfig(const opt::ParamsAPI2& args)
 {
-	enum class Color : char {
-		PIN,
-		VALUE,
-	};
-	color::palette<Color> colors{
-		std::make_pair(Color::PIN, color::setcolor::cyan),
-		std::make_pair(Color::VALUE, color::setcolor::yellow)
-	};
+	rpigpio::RealtimeConfig config;
+	if (const auto& cpu{ args.typegetv_any<opt::Option>("cpu") }; cpu.has_value())
+		config.cpu = std::stoi(cpu.value());
+	if (const auto& priority{ args.typegetv_any<opt::Option>("priority") }; priority.has_value())
+		config.priority = std::stoi(priority.value());
+	return config;
+}
 
-	try {
-		opt::ParamsAPI2 args{ argc, argv, 'I', "on", "high", 'O', "off", "low", 'Q', 'G', "get", 's', "set" };
+/**
+ * Warns about the real-time settings that couldn't be applied
+ */
+void WarnRealtime(const rpigpio::RealtimeContext& realtime, const rpigpio::RealtimeConfig& config, color::palette<Color>& colors)
+{
+	if (!realtime.pinned())
+		std::cerr << colors.get_warn() << "Not pinned to a CPU, isolate one or specify '--cpu'." << std::endl;
+	if (config.priority > 0 && !realtime.scheduled())
+		std::cerr << colors.get_warn() << "Failed to switch to SCHED_FIFO, running with the normal scheduler." << std::endl;
+	if (!realtime.locked())
+		std::cerr << colors.get_warn() << "Failed to lock memory, page faults may show up in the results." << std::endl;
+}
 
-		const bool quiet{ args.check_any<opt::Flag, opt::Option>('q', "quiet") };
-		colors.setEnabled(!quiet);
+template<typename Backend>
+int Run(const opt::ParamsAPI2& args, Backend backend, color::palette<Color>& colors, const bool quiet)
+{
+	// copied, the emulator stays reachable through backend
+	rpigpio::BasicGPIO<Backend> gpio{ backend };
+	if (!gpio.connect())
+		throw make_exception("Failed to connect to the GPIO peripheral!");
 
+	// --record
+	const auto& recordPath{ args.typegetv_any<opt::Option>("record") };
+	std::optional<rpigpio::TraceRecorder> recorder;
+	if (recordPath.has_value()) {
+		if constexpr (!rpigpio::TRACE_ENABLED)
+			throw make_exception("Trace recording isn't available, rebuild with RPI_GPIO_ENABLE_TRACE!");
+		const auto& records{ args.typegetv_any<opt::Option>("records") };
+		recorder.emplace(records.has_value() ? std::stoull(records.value()) : 1048576ull);
+		gpio.setRecorder(&recorder.value());
+	}
 
-		if (const bool empty{ args.empty() }; empty || args.check_any<opt::Flag, opt::Option>('h', "help")) {
-			std::cout << Help();
-			if (empty)
-				throw make_exception("No arguments specified! ( Nothing to do. )");
-			return 0;
+	// -R, -r, --reset
+	if (args.check_any<opt::Flag, opt::Option>('R', 'r', "reset"))
+		gpio.reset();
+
+	// -s, --set
+	rpigpio::ModeConfig modes;
+	for (const auto& arg : args.typegetv_all<opt::Flag, opt::Option>('s', "set")) {
+		const auto& [pinstr, modestr] { str::split(arg, ':') };
+
+		const auto& pinopt{ str::optional::stoui(pinstr) };
+		const auto& modeopt{ StringToPinMode(modestr) };
+
+		if (!pinopt.has_value()) {
+			std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
+			continue;
 		}
-		else if (args.check_any<opt::Flag, opt::Option>('v', "version")) {
-			if (!quiet)
-				std::cout << PROGRAM_NAME << "  v";
-			std::cout << gpiocli_VERSION_EXTENDED << std::endl;
-			return 0;
+		else if (!modeopt.has_value()) {
+			std::cerr << colors.get_warn() << "Invalid Mode: '" << modestr << "'" << std::endl;
+			continue;
 		}
 
-		rpigpio::GPIO gpio;
-		if (!gpio.connect())
-			throw make_exception("Failed to connect to the GPIO peripheral!");
+		modes.set(pinopt.value(), modeopt.value());
+	}
+	gpio.pinMode(modes);
 
-		// -R, -r, --reset
-		if (args.check_any<opt::Flag, opt::Option>('R', 'r', "reset"))
-			gpio.reset();
+	// -p, --pull
+	rpigpio::PullConfig pulls;
+	for (const auto& arg : args.typegetv_all<opt::Flag, opt::Option>('p', "pull")) {
+		const auto& [pinstr, pullstr] { str::split(arg, ':') };
 
-		// -s, --set
-		for (const auto& arg : args.typegetv_all<opt::Flag, opt::Option>('s', "set")) {
-			const auto& [pinstr, modestr] { str::split(arg, ':') };
+		const auto& pinopt{ str::optional::stoui(pinstr) };
+		const auto& pullopt{ StringToPullMode(pullstr) };
 
-			const auto& pinopt{ str::optional::stoui(pinstr) };
-			const auto& modeopt{ StringToPinMode(modestr) };
+		if (!pinopt.has_value()) {
+			std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
+			continue;
+		}
+		else if (!pullopt.has_value()) {
+			std::cerr << colors.get_warn() << "Invalid Pull: '" << pullstr << "'" << std::endl;
+			continue;
+		}
 
-			if (!pinopt.has_value()) {
-				std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
-				continue;
-			}
-			else if (!modeopt.has_value()) {
-				std::cerr << colors.get_warn() << "Invalid Mode: '" << modestr << "'" << std::endl;
-				continue;
-			}
+		pulls.set(pinopt.value(), pullopt.value());
+	}
+	gpio.pinPull(pulls);
+
+	// -I, --on, --high
+	for (const auto& pinstr : args.typegetv_all<opt::Flag, opt::Option>('I', "on", "high")) {
+		const auto& pinopt{ str::optional::stoui(pinstr) };
+
+		if (pinopt.has_value())
+			gpio.digitalWrite(pinopt.value(), true);
+		else
+			std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
+	}
+
+	// -O, --off, --low
+	for (const auto& pinstr : args.typegetv_all<opt::Flag, opt::Option>('O', "off", "low")) {
+		const auto& pinopt{ str::optional::stoui(pinstr) };
+
+		if (pinopt.has_value())
+			gpio.digitalWrite(pinopt.value(), false);
+		else
+			std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
+	}
 
-			gpio.pinMode(pinopt.value(), modeopt.value());
+	// -Q, -G, --get
+	const auto& queryPins{ args.typegetv_all<opt::Flag, opt::Option>('Q', 'G', "get") };
+	const auto& longest{ str::longestLength(queryPins) };
+	// all queried pins come from the same snapshot
+	const rpigpio::PinLevels levels{ queryPins.empty() ? rpigpio::PinLevels{} : gpio.readAll() };
+	for (const auto& pinstr : queryPins) {
+		const auto& pinopt{ str::optional::stoui(pinstr) };
+
+		if (pinopt.has_value()) {
+			if (!quiet)
+				std::cout << colors(Color::PIN) << pinstr << colors() << indent(longest - pinstr.size()) << " = ";
+			std::cout << colors(Color::VALUE) << levels[pinopt.value()] << colors() << '\n';
 		}
+		else
+			std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
+	}
 
-		// -I, --on, --high
-		for (const auto& pinstr : args.typegetv_all<opt::Flag, opt::Option>('I', "on", "high")) {
-			const auto& pinopt{ str::optional::stoui(pinstr) };
+	// --batch
+	if (args.check_any<opt::Option>("batch")) {
+		const auto& file{ args.typegetv_any<opt::Option>("batch") };
+		if (!file.has_value() || file.value() == "-")
+			RunBatch(gpio, std::cin, quiet);
+		else if (std::ifstream ifs{ file.value() }; ifs.is_open())
+			RunBatch(gpio, ifs, quiet);
+		else throw make_exception("Failed to open batch file '", file.value(), "'!");
+	}
+
+	// --replay
+	if (const auto& replayPath{ args.typegetv_any<opt::Option>("replay") }; replayPath.has_value()) {
+		rpigpio::WaveformPlayer player;
+		player.calibrate();
+		const auto& stats{ rpigpio::replayTrace(gpio, replayPath.value(), player) };
+
+		if (!quiet)
+			std::cout
+			<< "Writes:      " << stats.frames << '\n'
+			<< "Deviation:   " << stats.p50 << " ns (median), " << stats.p99 << " ns (p99), " << stats.max << " ns (max)" << '\n';
+	}
 
-			if (pinopt.has_value())
-				gpio.digitalWrite(pinopt.value(), true);
+	// --capture
+	if (const auto& captureMask{ args.typegetv_any<opt::Option>("capture") }; captureMask.has_value()) {
+		const auto& outPath{ args.typegetv_any<opt::Option>("out") };
+		if (!outPath.has_value())
+			throw make_exception("'--capture' requires an output file, specify one with '--out'!");
+
+		const uint64_t mask{ std::stoull(captureMask.value(), nullptr, 0) };
+		const auto& duration{ args.typegetv_any<opt::Option>("duration") };
+		const auto& records{ args.typegetv_any<opt::Option>("records") };
+
+		rpigpio::CaptureWriter out{ outPath.value(), records.has_value() ? std::stoull(records.value()) : 1048576ull };
+		std::signal(SIGINT, OnInterrupt);
+		const auto& stats{ rpigpio::capture(gpio, out, mask, duration.has_value() ? std::stoull(duration.value()) * 1000000ull : 0ull, interrupted) };
+
+		if (!quiet)
+			std::cout
+			<< "Samples:     " << stats.samples << '\n'
+			<< "Changes:     " << stats.changes << '\n'
+			<< "Duration:    " << stats.duration / 1000000 << " ms" << '\n'
+			<< "Sample Rate: " << static_cast<uint64_t>(stats.sampleRate()) << " samples/s" << '\n';
+	}
+
+	// --watch
+	if (const auto& watchPins{ args.typegetv_any<opt::Option>("watch") }; watchPins.has_value()) {
+		rpigpio::PinSet pins;
+		std::stringstream ss{ watchPins.value() };
+		for (std::string pinstr; std::getline(ss, pinstr, ',');) {
+			const auto& pinopt{ str::optional::stoui(pinstr) };
+			if (pinopt.has_value() && pinopt.value() < rpigpio::PIN_COUNT)
+				pins.add(pinopt.value());
 			else
 				std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
 		}
 
-		// -O, --off, --low
-		for (const auto& pinstr : args.typegetv_all<opt::Flag, opt::Option>('O', "off", "low")) {
-			const auto& pinopt{ str::optional::stoui(pinstr) };
+		const auto& interval{ args.typegetv_any<opt::Option>("interval") };
+		const auto& duration{ args.typegetv_any<opt::Option>("duration") };
+		std::signal(SIGINT, OnInterrupt);
+		std::signal(SIGTERM, OnInterrupt);
+		const auto& stats{ RunWatch(
+			gpio,
+			pins,
+			std::chrono::microseconds{ interval.has_value() ? std::stoull(interval.value()) : 1000ull },
+			duration.has_value() ? std::stoull(duration.value()) * 1000000ull : 0ull,
+			args.check_any<opt::Option>("binary"),
+			interrupted
+		) };
+		interrupted.store(false);
 
-			if (pinopt.has_value())
-				gpio.digitalWrite(pinopt.value(), false);
-			else
-				std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
+		if (!quiet)
+			std::cerr
+			<< "Changes:     " << stats.changes << '\n'
+			<< "Dropped:     " << stats.dropped << '\n'
+			<< "Coalesced:   " << stats.coalesced << '\n'
+			<< "Polls:       " << stats.polls << '\n';
+	}
+
+	// --jitter
+	if (const auto& jitterPeriod{ args.typegetv_any<opt::Option>("jitter") }; jitterPeriod.has_value()) {
+		const uint64_t period{ std::stoull(jitterPeriod.value()) * 1000ull };
+		if (period == 0)
+			throw make_exception("'--jitter' expects a period of at least 1 microsecond!");
+
+		const auto& config{ GetRealtimeConfig(args) };
+		const auto& duration{ args.typegetv_any<opt::Option>("duration") };
+		std::signal(SIGINT, OnInterrupt);
+		std::signal(SIGTERM, OnInterrupt);
+		JitterStats stats;
+		{
+			const rpigpio::RealtimeContext realtime{ config };
+			WarnRealtime(realtime, config, colors);
+			realtime.prefault(gpio);
+
+			stats = RunJitter(gpio, period, duration.has_value() ? std::stoull(duration.value()) * 1000000ull : 0ull, interrupted);
 		}
+		interrupted.store(false);
 
-		// -Q, -G, --get
-		const auto& queryPins{ args.typegetv_all<opt::Flag, opt::Option>('Q', 'G', "get") };
-		const auto& longest{ str::longestLength(queryPins) };
-		for (const auto& pinstr : queryPins) {
-			const auto& pinopt{ str::optional::stoui(pinstr) };
+		if (!quiet)
+			std::cout << "Samples:     " << stats.wakeup.samples << '\n' << "Overruns:    " << stats.overruns << '\n';
+		std::cout << std::left << std::setw(13) << "" << std::right;
+		for (const auto& column : { "min", "p50", "p90", "p99", "p99.9", "max" })
+			std::cout << std::setw(10) << column;
+		std::cout << '\n';
+		for (const auto& [name, histogram] : { std::make_pair("Wakeup ns", &stats.wakeup), std::make_pair("Read ns", &stats.access) }) {
+			std::cout << std::left << std::setw(13) << name << std::right << std::setw(10) << (histogram->samples ? histogram->min : 0);
+			for (const double p : { 50.0, 90.0, 99.0, 99.9 })
+				std::cout << std::setw(10) << histogram->percentile(p);
+			std::cout << std::setw(10) << histogram->max << '\n';
+		}
+	}
+
+	// --loopback
+	if (const auto& loopbackPins{ args.typegetv_any<opt::Option>("loopback") }; loopbackPins.has_value()) {
+		const auto& [outstr, instr] { str::split(loopbackPins.value(), ':') };
+		const auto& outopt{ str::optional::stoui(outstr) };
+		const auto& inopt{ str::optional::stoui(instr) };
+		if (!outopt.has_value() || !inopt.has_value() || outopt.value() >= rpigpio::PIN_COUNT || inopt.value() >= rpigpio::PIN_COUNT || outopt.value() == inopt.value())
+			throw make_exception("'--loopback' expects two different pin numbers: '<OUT>:<IN>'!");
+
+		if constexpr (Backend::emulated)
+			backend.emulator->loopback(outopt.value(), inopt.value());
+
+		const auto& iterations{ args.typegetv_any<opt::Option>("iterations") };
+		const auto& config{ GetRealtimeConfig(args) };
+		std::array<LoopbackResult, static_cast<unsigned int>(LoopbackMethod::COUNT)> results;
+		{
+			const rpigpio::RealtimeContext realtime{ config };
+			WarnRealtime(realtime, config, colors);
+			realtime.prefault(gpio);
+
+			results = RunLoopback(gpio, outopt.value(), inopt.value(), iterations.has_value() ? std::stoull(iterations.value()) : 10000ull, 1000000ull);
+		}
+
+		if (results[0].round_trip.samples == 0)
+			throw make_exception("Pin ", inopt.value(), " never followed pin ", outopt.value(), ", check the wiring!");
 
-			if (pinopt.has_value()) {
-				if (!quiet)
-					std::cout << colors(Color::PIN) << pinstr << colors() << indent(longest - pinstr.size()) << " = ";
-				std::cout << colors(Color::VALUE) << gpio.pinLev(pinopt.value()) << colors() << '\n';
+		std::cout << std::left << std::setw(14) << "" << std::right;
+		for (const auto& column : { "samples", "timeouts", "min", "p50", "p90", "p99", "p99.9", "max" })
+			std::cout << std::setw(10) << column;
+		std::cout << '\n';
+		for (unsigned int method{ 0 }; method < results.size(); ++method) {
+			const auto& histogram{ results[method].round_trip };
+			std::cout << std::left << std::setw(14) << LoopbackMethodName(static_cast<LoopbackMethod>(method)) << std::right
+				<< std::setw(10) << histogram.samples << std::setw(10) << results[method].timeouts << std::setw(10) << (histogram.samples ? histogram.min : 0);
+			for (const double p : { 50.0, 90.0, 99.0, 99.9 })
+				std::cout << std::setw(10) << histogram.percentile(p);
+			std::cout << std::setw(10) << histogram.max << '\n';
+		}
+	}
+
+	// --daemon
+	if (const auto& socketPath{ args.typegetv_any<opt::Option>("daemon") }; socketPath.has_value()) {
+		const auto& socketMode{ args.typegetv_any<opt::Option>("socket-mode") };
+		rpigpio::RemoteServer server{ socketPath.value(), static_cast<mode_t>(socketMode.has_value() ? std::stoul(socketMode.value(), nullptr, 8) : 0660) };
+		std::signal(SIGINT, OnInterrupt);
+		std::signal(SIGTERM, OnInterrupt);
+		const auto& stats{ server.serve(gpio, interrupted) };
+
+		if (!quiet)
+			std::cout
+			<< "Connections: " << stats.connections << '\n'
+			<< "Requests:    " << stats.requests << '\n'
+			<< "Operations:  " << stats.ops << '\n';
+	}
+
+	// --record
+	if (recorder.has_value()) {
+		gpio.setRecorder(nullptr);
+		recorder->save(recordPath.value());
+		if (recorder->dropped())
+			std::cerr << colors.get_warn() << "Trace buffer full, " << recorder->dropped() << " writes were not recorded! Increase '--records'." << std::endl;
+	}
+
+	// --stats
+	if (args.check_any<opt::Option>("stats"))
+		std::cout << rpigpio::stats::snapshot();
+
+	return 0;
+}
+
+/**
+ * Compares two trace files
+ * @return 0 when their pin activity is identical, 1 otherwise
+ */
+int Diff(const opt::ParamsAPI2& args, const std::string& paths, const bool quiet)
+{
+	const auto& [a, b] { str::split(paths, ',') };
+	if (a.empty() || b.empty())
+		throw make_exception("'--diff' expects two trace files separated by a comma!");
+
+	const auto& window{ args.typegetv_any<opt::Option>("window") };
+	const auto& tolerance{ args.typegetv_any<opt::Option>("tolerance") };
+	const auto& diff{ rpigpio::diffTraces(
+		a,
+		b,
+		window.has_value() ? std::stoull(window.value()) * 1000ull : 0ull,
+		tolerance.has_value() ? std::stoull(tolerance.value()) * 1000ull : UINT64_MAX
+	) };
+
+	if (!quiet) {
+		std::cout
+			<< "Changes:     " << diff.states_a << " / " << diff.states_b << '\n'
+			<< "Mismatches:  " << diff.mismatches << '\n'
+			<< "Late:        " << diff.late << '\n'
+			<< "Max Skew:    " << diff.max_skew << " ns" << '\n';
+		if (diff.found) {
+			std::cout << "First mismatch at change " << diff.first_index << ":\n";
+			for (const auto& [name, state] : { std::make_pair(a, diff.first_a), std::make_pair(b, diff.first_b) }) {
+				std::cout << "  " << name << ": t=" << state.time << " ns, levels=0x" << std::hex << state.levels << ", fsel=";
+				for (unsigned int rnum{ 0 }; rnum < 6; ++rnum)
+					std::cout << (rnum ? "," : "") << "0x" << state.fsel[rnum];
+				std::cout << std::dec << '\n';
 			}
-			else
-				std::cerr << colors.get_warn() << "Invalid Pin Number: '" << pinstr << "'" << std::endl;
 		}
+	}
+	return diff.identical() && diff.late == 0 ? 0 : 1;
+}
+
+int main(const int argc, char** argv)
+{
+	color::palette<Color> colors{
+		std::make_pair(Color::PIN, color::setcolor::cyan),
+		std::make_pair(Color::VALUE, color::setcolor::yellow)
+	};
+
+	try {
+		opt::ParamsAPI2 args{ argc, argv, 'I', "on", "high", 'O', "off", "low", 'Q', 'G', "get", 's', "set", 'p', "pull", "capture", "out", "duration", "records", "watch", "interval", "jitter", "loopback", "iterations", "cpu", "priority", "batch", "record", "replay", "diff", "window", "tolerance", "image", "daemon", "socket-mode" };
+
+		const bool quiet{ args.check_any<opt::Flag, opt::Option>('q', "quiet") };
+		colors.setEnabled(!quiet);
+
+
+		if (const bool empty{ args.empty() }; empty || args.check_any<opt::Flag, opt::Option>('h', "help")) {
+			std::cout << Help();
+			if (empty)
+				throw make_exception("No arguments specified! ( Nothing to do. )");
+			return 0;
+		}
+		else if (args.check_any<opt::Flag, opt::Option>('v', "version")) {
+			if (!quiet)
+				std::cout << PROGRAM_NAME << "  v";
+			std::cout << gpiocli_VERSION_EXTENDED << std::endl;
+			return 0;
+		}
+
+		// --diff
+		if (const auto& diffPaths{ args.typegetv_any<opt::Option>("diff") }; diffPaths.has_value())
+			return Diff(args, diffPaths.value(), quiet);
 
-		return 0;
+		// --image
+		if (const auto& image{ args.typegetv_any<opt::Option>("image") }; image.has_value())
+			return Run(args, rpigpio::FileMem{ image.value() }, colors, quiet);
+		// --sim
+		else if (args.check_any<opt::Option>("sim"))
+			return Run(args, rpigpio::EmuMem{}, colors, quiet);
+		return Run(args, rpigpio::DevMem{}, colors, quiet);
 	} catch (const std::exception& ex) {
 		std::cerr << colors.get_fatal() << ex.what() << std::endl;
 		return 1;
@@ -0,0 +1,101 @@
+#pragma once
+#include <RPI-GPIO.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+/**
+ * Binary watch output, one record per changed pin
+ */
+struct WatchRecord {
+	uint64_t timestamp;     // Monotonic time of detection, in nanoseconds
+	uint32_t pin;           // Pin number
+	uint32_t level;         // New level
+};
+
+/**
+ * Watch statistics
+ */
+struct WatchStats {
+	uint64_t changes{ 0 };      // Number of changes written
+	uint64_t dropped{ 0 };      // Events lost because the event ring was full
+	uint64_t coalesced{ 0 };    // Events whose level didn't change, more than one edge happened between two polls
+	uint64_t polls{ 0 };        // Number of event register polls
+};
+
+/**
+ * Streams the level changes of pins, using GPEDS edge detection.
+ * Rising and falling edge detection is enabled on the pins for the duration of the watch,
+ * the previous enables are restored afterwards.
+ * @param gpio connected GPIO handler
+ * @param pins watched pins
+ * @param interval sleep between polls that found no event, 0 to busy poll
+ * @param duration watch duration in nanoseconds, 0 to run until stop is set
+ * @param binary write WatchRecord instead of text lines
+ * @param stop set to true to stop watching
+ * @return watch statistics
+ */
+template<typename Backend>
+WatchStats RunWatch(const rpigpio::BasicGPIO<Backend>& gpio, const rpigpio::PinSet& pins, const std::chrono::nanoseconds interval, const uint64_t duration, const bool binary, const std::atomic<bool>& stop)
+{
+	WatchStats stats;
+	std::string output;
+	const auto& flush{ [&]() {
+		if (output.empty()) return;
+		fwrite(output.data(), 1, output.size(), stdout);
+		fflush(stdout);
+		output.clear();
+	} };
+
+	const rpigpio::PinSet rising{ gpio.edgeDetectEnabled(rpigpio::EDGE_DETECT::RISING) };
+	const rpigpio::PinSet falling{ gpio.edgeDetectEnabled(rpigpio::EDGE_DETECT::FALLING) };
+	gpio.edgeDetect(pins, rpigpio::EDGE_DETECT::RISING);
+	gpio.edgeDetect(pins, rpigpio::EDGE_DETECT::FALLING);
+
+	rpigpio::PinLevels last{ gpio.readAll() };
+	rpigpio::EdgeDetector<Backend> detector{ gpio, pins, 4096, interval };
+	detector.start();
+
+	const uint64_t deadline{ duration ? rpigpio::monotonicNow() + duration : 0 };
+	rpigpio::EdgeEvent events[256];
+	while (!stop.load(std::memory_order_relaxed) && (!deadline || rpigpio::monotonicNow() < deadline)) {
+		const size_t n{ detector.drain(events, 256) };
+		for (size_t i{ 0 }; i < n; ++i) {
+			const auto& event{ events[i] };
+			for (unsigned int pin{ 0 }; pin < rpigpio::PIN_COUNT; ++pin) {
+				if (!event.pins.contains(pin)) continue;
+				const bool level{ event.levels[pin] };
+				if (level == last[pin]) {
+					++stats.coalesced;
+					continue;
+				}
+
+				if (binary) {
+					const WatchRecord record{ event.timestamp, pin, level };
+					output.append(reinterpret_cast<const char*>(&record), sizeof(record));
+				}
+				else output += std::to_string(event.timestamp) + ' ' + std::to_string(pin) + ' ' + (level ? '1' : '0') + '\n';
+				++stats.changes;
+			}
+			// an event only carries the levels of its pins
+			last = rpigpio::PinLevels{ (last.value & ~event.pins.mask()) | (event.levels.value & event.pins.mask()) };
+		}
+
+		// one write per drained batch
+		flush();
+		if (n == 0)
+			std::this_thread::sleep_for(interval.count() > 0 ? interval : std::chrono::nanoseconds{ 100000 });
+	}
+
+	detector.stop();
+	gpio.edgeDetect(pins & ~rising, rpigpio::EDGE_DETECT::RISING, false);
+	gpio.edgeDetect(pins & ~falling, rpigpio::EDGE_DETECT::FALLING, false);
+
+	stats.dropped = detector.dropped();
+	stats.polls = detector.pollCount();
+	flush();
+	return stats;
+}
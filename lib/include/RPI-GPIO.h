@@ -1,3 +1,18 @@
 #pragma once
 #include "memory.h"
 #include "gpio.h"
+#include "stats.h"
+#include "edge.h"
+#include "waveform.h"
+#include "softpwm.h"
+#include "capture.h"
+#include "remote.h"
+#include "executor.h"
+#include "debounce.h"
+#include "trace.h"
+#include "replay.h"
+#include "quadrature.h"
+#include "emulator.h"
+#include "pulse.h"
+#include "spi.h"
+#include "realtime.h"
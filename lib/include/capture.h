@@ -0,0 +1,246 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+#include "clock.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace rpigpio {
+	/**
+	 * Capture file layout.
+	 * A CaptureHeader followed by a ring of CaptureRecord, one record per change of the
+	 * captured pins. Each record holds the time elapsed since the previous record and
+	 * the number of samples the previous levels lasted. When the ring is full, the
+	 * oldest records are overwritten and the header origin moves forward.
+	 */
+	constexpr uint32_t CAPTURE_MAGIC = 0x43475052; // "RPGC"
+	constexpr uint32_t CAPTURE_VERSION = 1;
+
+	struct CaptureHeader {
+		uint32_t magic;             // CAPTURE_MAGIC
+		uint32_t version;           // CAPTURE_VERSION
+		uint64_t mask;              // Captured pins, bit n is pin n
+		uint64_t capacity;          // Number of records in the ring
+		uint64_t count;             // Number of records ever written
+		uint64_t origin_time;       // Monotonic time of the record preceding the oldest live record, in nanoseconds
+		uint64_t origin_levels;     // Levels at origin_time
+		uint64_t samples;           // Number of samples taken
+		uint64_t end_time;          // Monotonic time of the last sample, in nanoseconds
+	};
+
+	struct CaptureRecord {
+		uint32_t delta;             // Time since the previous record, in nanoseconds
+		uint32_t run;               // Number of samples the previous levels lasted
+		uint64_t levels;            // New levels of the captured pins
+	};
+
+	/**
+	 * Writes a capture file through a shared memory mapping
+	 */
+	class CaptureWriter {
+	private:
+		int fd{ -1 };
+		CaptureHeader* header{ nullptr };
+		CaptureRecord* records{ nullptr };
+		size_t length{ 0 };
+		uint64_t last_time{ 0 };
+		uint64_t last_levels{ 0 };
+
+		void push(uint32_t delta, uint32_t run, uint64_t levels);
+
+	public:
+		/**
+		 * Creates or truncates a capture file
+		 * @param path file path
+		 * @param capacity number of records in the ring
+		 */
+		CaptureWriter(const std::string& path, uint64_t capacity);
+		~CaptureWriter();
+
+		CaptureWriter(const CaptureWriter&) = delete;
+		CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+		/**
+		 * Starts a capture
+		 * @param mask captured pins
+		 * @param time monotonic time of the first sample
+		 * @param levels levels of the first sample
+		 */
+		void begin(uint64_t mask, uint64_t time, uint64_t levels);
+
+		/**
+		 * Appends a change
+		 * @param time monotonic time of the change
+		 * @param run number of samples the previous levels lasted
+		 * @param levels new levels
+		 */
+		void append(uint64_t time, uint32_t run, uint64_t levels);
+
+		/**
+		 * Ends a capture
+		 * @param time monotonic time of the last sample
+		 * @param samples number of samples taken
+		 */
+		void end(uint64_t time, uint64_t samples);
+	};
+
+	/**
+	 * A decoded change
+	 */
+	struct CaptureEvent {
+		uint64_t time;              // Monotonic time of the change, in nanoseconds
+		uint32_t run;               // Number of samples the previous levels lasted
+		PinLevels levels;           // New levels of the captured pins
+	};
+
+	/**
+	 * Reads a capture file in place, through a read-only memory mapping
+	 */
+	class CaptureReader {
+	private:
+		int fd{ -1 };
+		const CaptureHeader* header{ nullptr };
+		const CaptureRecord* records{ nullptr };
+		size_t length{ 0 };
+
+	public:
+		class iterator {
+		private:
+			const CaptureRecord* records;
+			uint64_t capacity;
+			uint64_t index;
+			uint64_t time;
+
+		public:
+			iterator(const CaptureRecord* records_p, uint64_t capacity_p, uint64_t index_p, uint64_t time_p)
+				: records{ records_p }, capacity{ capacity_p }, index{ index_p }, time{ time_p + (capacity_p ? records_p[index_p % capacity_p].delta : 0) } {}
+
+			CaptureEvent operator*() const
+			{
+				const auto& record{ records[index % capacity] };
+				return { time, record.run, PinLevels{ record.levels } };
+			}
+
+			iterator& operator++()
+			{
+				++index;
+				time += records[index % capacity].delta;
+				return *this;
+			}
+
+			bool operator==(const iterator& o) const { return index == o.index; }
+			bool operator!=(const iterator& o) const { return index != o.index; }
+		};
+
+		/**
+		 * Maps a capture file
+		 * @param path file path
+		 */
+		explicit CaptureReader(const std::string& path);
+		~CaptureReader();
+
+		CaptureReader(const CaptureReader&) = delete;
+		CaptureReader& operator=(const CaptureReader&) = delete;
+
+		/**
+		 * @return the file header
+		 */
+		const CaptureHeader& info(void) const { return *header; }
+
+		/**
+		 * @return index of the oldest live record
+		 */
+		uint64_t first(void) const { return header->count > header->capacity ? header->count - header->capacity : 0; }
+
+		/**
+		 * @return number of live records
+		 */
+		uint64_t size(void) const { return header->count - first(); }
+
+		iterator begin(void) const { return { records, header->capacity, first(), header->origin_time }; }
+		iterator end(void) const { return { records, header->capacity, header->count, 0 }; }
+	};
+
+	/**
+	 * Capture statistics
+	 */
+	struct CaptureStats {
+		uint64_t samples{ 0 };      // Number of samples
+		uint64_t changes{ 0 };      // Number of records written
+		uint64_t duration{ 0 };     // Capture duration, in nanoseconds
+
+		double sampleRate(void) const { return duration ? static_cast<double>(samples) * 1e9 / static_cast<double>(duration) : 0.0; }
+	};
+
+	/**
+	 * Samples GPLEV0/GPLEV1 in a tight loop and records every change of the masked pins
+	 * @param gpio connected GPIO handler
+	 * @param out capture file
+	 * @param mask captured pins, bit n is pin n
+	 * @param duration capture duration in nanoseconds, 0 to run until stop is set
+	 * @param stop set to true to stop the capture
+	 * @return capture statistics
+	 */
+	template<typename Backend>
+	CaptureStats capture(const BasicGPIO<Backend>& gpio, CaptureWriter& out, uint64_t mask, uint64_t duration, const std::atomic<bool>& stop)
+	{
+		CaptureStats stats;
+		uint64_t levels{ gpio.readAll().value & mask };
+		const uint64_t start{ monotonicNow() };
+		const uint64_t deadline{ duration ? start + duration : std::numeric_limits<uint64_t>::max() };
+		uint32_t run{ 1 };
+		uint64_t now{ start };
+		out.begin(mask, start, levels);
+
+		while (true) {
+			const uint64_t sample{ gpio.readAll().value & mask };
+			++stats.samples;
+			if (sample != levels) {
+				now = monotonicNow();
+				out.append(now, run, sample);
+				++stats.changes;
+				levels = sample;
+				run = 1;
+			}
+			else if (run != std::numeric_limits<uint32_t>::max())
+				++run;
+
+			// check for the end every 1024 samples
+			if ((stats.samples & 1023) == 0) {
+				now = monotonicNow();
+				if (now >= deadline || stop.load(std::memory_order_relaxed)) break;
+			}
+		}
+
+		stats.duration = now - start;
+		out.end(now, stats.samples);
+		return stats;
+	}
+}
@@ -0,0 +1,92 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+
+#include <cstdint>
+
+namespace rpigpio {
+	/**
+	 * Debounces all pins at once with vertical counters.
+	 * Bit n of every counter plane holds one bit of the counter of pin n, so a sample
+	 * costs the same few bitwise operations whatever the number of pins. A pin's
+	 * counter counts the consecutive samples that differ from its debounced level and
+	 * restarts when a sample agrees with it. The debounced level flips when the counter
+	 * reaches the threshold.
+	 */
+	class Debouncer {
+	public:
+		static constexpr unsigned int PLANES = 8;
+		static constexpr unsigned int MAX_THRESHOLD = (1u << PLANES) - 1;
+
+	private:
+		uint64_t mask;              // Debounced pins
+		uint64_t stable;            // Debounced levels
+		uint64_t count[PLANES]{};   // Counter bit planes, plane b holds bit b of every counter
+		uint64_t target[PLANES]{};  // Threshold bit planes
+		unsigned int threshold;     // Consecutive differing samples needed to flip
+
+	public:
+		/**
+		 * Class constructor
+		 * @param threshold_p number of consecutive samples a new level must last, 1 to MAX_THRESHOLD
+		 * @param pins debounced pins
+		 * @param initial initial debounced levels
+		 */
+		explicit Debouncer(unsigned int threshold_p, const PinSet& pins = PinSet::fromMask((1ull << PIN_COUNT) - 1), const PinLevels& initial = PinLevels{});
+
+		/**
+		 * Feeds a sample
+		 * @param sample levels of all pins, from GPIO::readAll
+		 * @return pins whose debounced level changed
+		 */
+		PinSet update(const PinLevels& sample);
+
+		/**
+		 * Samples the levels and feeds them
+		 * @param gpio connected GPIO handler
+		 * @return pins whose debounced level changed
+		 */
+		template<typename Backend>
+		PinSet update(const BasicGPIO<Backend>& gpio) { return update(gpio.readAll()); }
+
+		/**
+		 * Restarts from known levels, clearing the counters
+		 * @param initial debounced levels
+		 */
+		void reset(const PinLevels& initial);
+
+		/**
+		 * @return debounced levels, pins that aren't debounced read as LOW
+		 */
+		PinLevels levels(void) const { return PinLevels{ stable }; }
+
+		/**
+		 * @return pins being counted towards a change
+		 */
+		PinSet pending(void) const;
+	};
+}
@@ -0,0 +1,129 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+#include "ring.h"
+#include "clock.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace rpigpio {
+	/**
+	 * A batch of detected events
+	 */
+	struct EdgeEvent {
+		uint64_t timestamp{ 0 };    // Monotonic time of detection, in nanoseconds
+		PinSet pins;                // Pins that had a pending event
+		PinLevels levels;           // Levels of all pins, read right after the events
+	};
+
+	/**
+	 * Event detection engine.
+	 * A poller thread harvests and clears GPEDS0/GPEDS1 and publishes the events in a
+	 * lock-free ring, which one consumer thread drains in batches.
+	 * Event detection must be enabled on the pins with GPIO::edgeDetect.
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<typename Backend = DevMem>
+	class EdgeDetector {
+	private:
+		const BasicGPIO<Backend>& gpio;
+		SpscRing<EdgeEvent> ring;
+		PinSet pins;                                // Harvested pins
+		std::chrono::nanoseconds interval;          // Sleep between empty polls, 0 to spin
+		std::atomic<bool> running{ false };
+		std::atomic<uint64_t> polls{ 0 };           // Number of polls
+		std::thread poller;
+
+		void run(void)
+		{
+			while (running.load(std::memory_order_relaxed)) {
+				const PinSet events{ gpio.takeEvents(pins) };
+				polls.fetch_add(1, std::memory_order_relaxed);
+				if (!events.empty())
+					ring.push({ monotonicNow(), events, gpio.readAll() });
+				else if (interval.count() > 0)
+					std::this_thread::sleep_for(interval);
+			}
+		}
+
+	public:
+		/**
+		 * Class constructor
+		 * @param gpio_p connected GPIO handler
+		 * @param pins_p pins to harvest
+		 * @param capacity capacity of the event ring
+		 * @param interval_p sleep between polls that found no event, 0 to busy poll
+		 */
+		EdgeDetector(const BasicGPIO<Backend>& gpio_p, PinSet pins_p, size_t capacity = 4096, std::chrono::nanoseconds interval_p = std::chrono::nanoseconds{ 0 })
+			: gpio{ gpio_p }, ring{ capacity }, pins{ pins_p }, interval{ interval_p } {}
+
+		~EdgeDetector() { stop(); }
+
+		EdgeDetector(const EdgeDetector&) = delete;
+		EdgeDetector& operator=(const EdgeDetector&) = delete;
+
+		/**
+		 * Starts the poller thread, pending events are discarded first
+		 */
+		void start(void)
+		{
+			if (running.exchange(true)) return;
+			gpio.clearEvents(pins);
+			poller = std::thread{ &EdgeDetector::run, this };
+		}
+
+		/**
+		 * Stops the poller thread
+		 */
+		void stop(void)
+		{
+			running.store(false);
+			if (poller.joinable()) poller.join();
+		}
+
+		/**
+		 * Drains up to max events, from a single consumer thread
+		 * @param out destination array
+		 * @param max maximum number of events
+		 * @return number of events
+		 */
+		size_t drain(EdgeEvent* out, size_t max) { return ring.pop(out, max); }
+
+		/**
+		 * @return number of events lost because the ring was full
+		 */
+		uint64_t dropped(void) const { return ring.dropped(); }
+
+		/**
+		 * @return number of times the status registers were polled
+		 */
+		uint64_t pollCount(void) const { return polls.load(std::memory_order_relaxed); }
+	};
+}
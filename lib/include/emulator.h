@@ -0,0 +1,196 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace rpigpio {
+	/**
+	 * A scripted change of the externally driven inputs
+	 */
+	struct StimulusStep {
+		uint64_t at;            // Emulated cycle of the change, relative to the call to Bcm2835Emulator::script
+		PinSet pins;            // Pins driven from this cycle on
+		PinSet levels;          // Levels driven on the pins, pins not in the set are driven LOW
+	};
+
+	/**
+	 * Behavioral model of the BCM2835 GPIO block.
+	 * Implements the register semantics instead of plain memory:
+	 * - GPSETn/GPCLRn set and clear the output latch and read as 0
+	 * - GPLEVn reflect the pins: the output latch for OUTPUT pins, otherwise the
+	 *   external drive, a loopback from another pin, the pull, or the last level
+	 * - Level changes latch events in GPEDSn according to the edge and level detect
+	 *   enables, GPEDSn is write-1-to-clear
+	 * - A GPPUDCLKn write applies the GPPUD control to the clocked pins
+	 * Emulated time advances by one cycle per register access, scripted stimulus is
+	 * applied at the cycle it is due. All accesses are serialized, several threads can
+	 * share one emulator.
+	 */
+	class Bcm2835Emulator {
+	private:
+		struct Spinlock {
+			std::atomic_flag flag = ATOMIC_FLAG_INIT;
+			void lock(void) { while (flag.test_and_set(std::memory_order_acquire)) {} }
+			void unlock(void) { flag.clear(std::memory_order_release); }
+		};
+
+		mutable Spinlock busy;              // Register accesses are short, a mutex would dominate them
+		uint32_t regs[PAGE_SIZE / 4]{};     // GPFSEL, enables, GPPUD, GPPUDCLK and reserved registers
+		uint64_t latch{ 0 };                // Output latch
+		uint64_t outputs{ 0 };              // Pins in OUTPUT mode
+		uint64_t level{ 0 };                // Pin levels
+		uint64_t events{ 0 };               // Latched events
+		uint64_t pull_up{ 0 };              // Pins pulled up
+		uint64_t pull_down{ 0 };            // Pins pulled down
+		uint64_t driven{ 0 };               // Pins driven externally
+		uint64_t input{ 0 };                // External drive levels
+		std::vector<std::pair<unsigned int, unsigned int>> loops;   // Loopbacks, source pin to destination pin
+		std::vector<StimulusStep> steps;    // Pending script, sorted by cycle
+		size_t next_step{ 0 };
+		uint64_t cycle{ 0 };
+
+		uint64_t pair(uint32_t off0) const { return static_cast<uint64_t>(regs[off0 / 4 + 1]) << 32 | regs[off0 / 4]; }
+
+		/**
+		 * Advances emulated time by one cycle, applying due stimulus
+		 */
+		void tick(void);
+
+		/**
+		 * Recomputes the pin levels and latches the events
+		 */
+		void update(void);
+
+		/**
+		 * Latches the level detect events of the current levels
+		 */
+		void detectLevels(void);
+
+	public:
+		Bcm2835Emulator() = default;
+		Bcm2835Emulator(const Bcm2835Emulator&) = delete;
+		Bcm2835Emulator& operator=(const Bcm2835Emulator&) = delete;
+
+		/**
+		 * Reads a register
+		 * @param off register offset
+		 * @return the register value
+		 */
+		uint32_t load(uint32_t off);
+
+		/**
+		 * Writes a register
+		 * @param off register offset
+		 * @param value written value
+		 */
+		void store(uint32_t off, uint32_t value);
+
+		/**
+		 * Drives inputs externally, overriding loopbacks and pulls
+		 * @param pins driven pins
+		 * @param levels levels driven on the pins
+		 */
+		void drive(const PinSet& pins, const PinSet& levels);
+
+		/**
+		 * Stops driving inputs externally
+		 * @param pins released pins
+		 */
+		void release(const PinSet& pins);
+
+		/**
+		 * Wires a pin to another one, as with a jumper: the destination follows the level of the source
+		 * @param from source pin
+		 * @param to destination pin
+		 */
+		void loopback(unsigned int from, unsigned int to);
+
+		/**
+		 * Removes the loopbacks driving a pin
+		 * @param to destination pin
+		 */
+		void unloop(unsigned int to);
+
+		/**
+		 * Replaces the stimulus script
+		 * @param script changes of the external drive, with cycles relative to now
+		 */
+		void script(std::vector<StimulusStep> script);
+
+		/**
+		 * @return current pin levels
+		 */
+		PinLevels levels(void) const;
+
+		/**
+		 * @return pins pulled up
+		 */
+		PinSet pullUps(void) const;
+
+		/**
+		 * @return pins pulled down
+		 */
+		PinSet pullDowns(void) const;
+
+		/**
+		 * @return number of register accesses so far
+		 */
+		uint64_t cycles(void) const;
+	};
+
+	/**
+	 * Emulated GPIO block, see Bcm2835Emulator.
+	 * Handlers built from copies of the same EmuMem share the emulator, so a test can keep
+	 * one to inject stimulus.
+	 */
+	struct EmuMem {
+		std::shared_ptr<Bcm2835Emulator> emulator;
+
+		static constexpr bool shared = false;
+		static constexpr bool emulated = true;
+
+		EmuMem() : emulator{ std::make_shared<Bcm2835Emulator>() } {}
+		explicit EmuMem(std::shared_ptr<Bcm2835Emulator> emulator_p) : emulator{ std::move(emulator_p) } {}
+
+		int open(void) const;
+		off_t offset(uint32_t) const { return 0; }
+
+		uint32_t load(uint32_t off) const { return emulator->load(off); }
+		void store(uint32_t off, uint32_t value) const { emulator->store(off, value); }
+	};
+
+	extern template class Bcm2835Periph<EmuMem>;
+	extern template class BasicGPIO<EmuMem>;
+
+	using EmuGPIO = BasicGPIO<EmuMem>;
+}
@@ -0,0 +1,306 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+#include "ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <thread>
+
+namespace rpigpio {
+	/**
+	 * A command queued to a GpioExecutor
+	 */
+	struct GpioCommand {
+		enum class Op : char {
+			WRITE,          // Set 'high', clear 'low'
+			MODE,           // Apply 'modes'
+			RESET,          // GPIO::reset
+			READ,           // Read all levels, then fulfill 'levels' or call 'callback'
+			SYNC,           // Fulfill 'done' once every previous command was executed
+		};
+
+		using Callback = void (*)(const PinLevels& levels, void* context);
+
+		Op op{ Op::WRITE };
+		PinSet high;
+		PinSet low;
+		ModeConfig modes;
+		std::shared_ptr<std::promise<PinLevels>> levels;   // Broken when the command is dropped unexecuted
+		std::shared_ptr<std::promise<void>> done;
+		Callback callback{ nullptr };
+		void* context{ nullptr };
+	};
+
+	/**
+	 * Thread-safe GPIO access through a command queue.
+	 * Any number of threads submit commands to a lock-free queue, a single executor
+	 * thread applies them to the registers, so read-modify-writes of GPFSEL never race.
+	 * Consecutive writes are merged into one store per GPSET/GPCLR register (the last
+	 * write of a pin wins) and consecutive mode changes into one ModeConfig. Commands
+	 * from one thread are executed in submission order.
+	 * While the executor runs, the GPIO handler must not be used directly.
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<typename Backend = DevMem>
+	class GpioExecutor {
+	private:
+		static constexpr size_t BATCH = 64;
+
+		const BasicGPIO<Backend>& gpio;
+		MpscRing<GpioCommand> queue;
+		std::chrono::nanoseconds idle;              // Sleep when the queue stays empty
+		std::atomic<bool> running{ false };
+		std::atomic<uint64_t> commands{ 0 };        // Number of commands executed
+		std::atomic<uint64_t> stores{ 0 };          // Number of merged write and mode flushes
+		std::thread executor;
+
+		void submit(const GpioCommand& cmd)
+		{
+			while (!queue.push(cmd))
+				std::this_thread::yield();
+		}
+
+		/**
+		 * Executes a batch of commands
+		 */
+		void execute(const GpioCommand* cmds, size_t n)
+		{
+			PinSet high, low;
+			ModeConfig modes;
+			bool pendingWrite{ false }, pendingModes{ false };
+
+			const auto& flushWrite{ [&]() {
+				if (!pendingWrite) return;
+				gpio.write(high, low);
+				high = low = PinSet{};
+				pendingWrite = false;
+				stores.fetch_add(1, std::memory_order_relaxed);
+			} };
+			const auto& flushModes{ [&]() {
+				if (!pendingModes) return;
+				gpio.pinMode(modes);
+				modes = ModeConfig{};
+				pendingModes = false;
+				stores.fetch_add(1, std::memory_order_relaxed);
+			} };
+
+			for (size_t i = 0; i < n; ++i) {
+				const GpioCommand& cmd = cmds[i];
+				if (cmd.op != GpioCommand::Op::MODE) flushModes();
+				if (cmd.op != GpioCommand::Op::WRITE) flushWrite();
+
+				switch (cmd.op) {
+				case GpioCommand::Op::WRITE:
+					high = (high & ~cmd.low) | cmd.high;
+					low = (low & ~cmd.high) | cmd.low;
+					pendingWrite = true;
+					break;
+				case GpioCommand::Op::MODE:
+					for (unsigned int rnum = 0; rnum < 6; ++rnum) {
+						modes.mask[rnum] |= cmd.modes.mask[rnum];
+						modes.value[rnum] = (modes.value[rnum] & ~cmd.modes.mask[rnum]) | cmd.modes.value[rnum];
+					}
+					pendingModes = true;
+					break;
+				case GpioCommand::Op::RESET:
+					gpio.reset();
+					break;
+				case GpioCommand::Op::READ: {
+					const PinLevels levels{ gpio.readAll() };
+					if (cmd.levels)
+						cmd.levels->set_value(levels);
+					else if (cmd.callback)
+						cmd.callback(levels, cmd.context);
+					break;
+				}
+				case GpioCommand::Op::SYNC:
+					cmd.done->set_value();
+					break;
+				}
+			}
+
+			flushModes();
+			flushWrite();
+			commands.fetch_add(n, std::memory_order_relaxed);
+		}
+
+		void run(void)
+		{
+			GpioCommand cmds[BATCH];
+			unsigned int empty{ 0 };
+			while (true) {
+				const bool stopping{ !running.load(std::memory_order_acquire) };
+				const size_t n = queue.pop(cmds, BATCH);
+				if (n) {
+					execute(cmds, n);
+					empty = 0;
+				}
+				else if (stopping && queue.size() == 0) break;
+				// spin, then yield, then sleep while the queue stays empty
+				else if (++empty > 1024 && idle.count() > 0)
+					std::this_thread::sleep_for(idle);
+				else if (empty > 64)
+					std::this_thread::yield();
+			}
+		}
+
+	public:
+		/**
+		 * Class constructor
+		 * @param gpio_p connected GPIO handler, only used by the executor thread while it runs
+		 * @param capacity capacity of the command queue
+		 * @param idle_p sleep of the executor when the queue stays empty, 0 to only yield
+		 */
+		explicit GpioExecutor(const BasicGPIO<Backend>& gpio_p, size_t capacity = 4096, std::chrono::nanoseconds idle_p = std::chrono::microseconds{ 50 })
+			: gpio{ gpio_p }, queue{ capacity }, idle{ idle_p } {}
+
+		~GpioExecutor() { stop(); }
+
+		GpioExecutor(const GpioExecutor&) = delete;
+		GpioExecutor& operator=(const GpioExecutor&) = delete;
+
+		/**
+		 * Starts the executor thread
+		 */
+		void start(void)
+		{
+			if (running.exchange(true)) return;
+			executor = std::thread{ &GpioExecutor::run, this };
+		}
+
+		/**
+		 * Stops the executor thread, once the commands already queued are executed.
+		 * Commands queued while no executor thread runs are executed once it is started again.
+		 * When the executor is destroyed first, the futures of their reads and syncs throw
+		 * std::future_error (broken_promise).
+		 */
+		void stop(void)
+		{
+			running.store(false, std::memory_order_release);
+			if (executor.joinable()) executor.join();
+		}
+
+		/**
+		 * Queues a write
+		 * @param high pins set to HIGH
+		 * @param low pins set to LOW
+		 */
+		void write(const PinSet& high, const PinSet& low)
+		{
+			GpioCommand cmd;
+			cmd.op = GpioCommand::Op::WRITE;
+			cmd.high = high;
+			cmd.low = low;
+			submit(cmd);
+		}
+
+		/**
+		 * Queues a mode change
+		 * @param pin pin number
+		 * @param mode new mode
+		 */
+		void pinMode(unsigned int pin, PIN_MODE mode) { pinMode(ModeConfig{}.set(pin, mode)); }
+
+		/**
+		 * Queues mode changes
+		 * @param config modes to apply
+		 */
+		void pinMode(const ModeConfig& config)
+		{
+			GpioCommand cmd;
+			cmd.op = GpioCommand::Op::MODE;
+			cmd.modes = config;
+			submit(cmd);
+		}
+
+		/**
+		 * Queues a reset
+		 */
+		void reset(void)
+		{
+			GpioCommand cmd;
+			cmd.op = GpioCommand::Op::RESET;
+			submit(cmd);
+		}
+
+		/**
+		 * Queues a read of all levels
+		 * @return levels, once every previously queued command of this thread was executed
+		 */
+		std::future<PinLevels> read(void)
+		{
+			GpioCommand cmd;
+			cmd.op = GpioCommand::Op::READ;
+			cmd.levels = std::make_shared<std::promise<PinLevels>>();
+			std::future<PinLevels> result{ cmd.levels->get_future() };
+			submit(cmd);
+			return result;
+		}
+
+		/**
+		 * Queues a read of all levels
+		 * @param callback called from the executor thread with the levels
+		 * @param context passed to the callback
+		 */
+		void read(GpioCommand::Callback callback, void* context)
+		{
+			GpioCommand cmd;
+			cmd.op = GpioCommand::Op::READ;
+			cmd.callback = callback;
+			cmd.context = context;
+			submit(cmd);
+		}
+
+		/**
+		 * Queues a barrier
+		 * @return ready once every previously queued command of this thread was executed
+		 */
+		std::future<void> sync(void)
+		{
+			GpioCommand cmd;
+			cmd.op = GpioCommand::Op::SYNC;
+			cmd.done = std::make_shared<std::promise<void>>();
+			std::future<void> result{ cmd.done->get_future() };
+			submit(cmd);
+			return result;
+		}
+
+		/**
+		 * @return number of commands executed
+		 */
+		uint64_t commandCount(void) const { return commands.load(std::memory_order_relaxed); }
+
+		/**
+		 * @return number of merged register updates, each one covers one or more write or mode commands
+		 */
+		uint64_t flushCount(void) const { return stores.load(std::memory_order_relaxed); }
+	};
+}
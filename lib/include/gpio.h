@@ -25,9 +25,12 @@ SOFTWARE.
 */
 #pragma once
 #include "memory.h"
+#include "stats.h"
+#include "trace.h"
 
 #include <utility>
 #include <cstdint>
+#include <initializer_list>
 
 namespace rpigpio {
 	/**  GPIO register adress offsets **/
@@ -48,7 +51,7 @@ namespace rpigpio {
 	constexpr uint32_t GPREN0 = 0x4c;
 	constexpr uint32_t GPREN1 = 0x50;
 
-	constexpr uint32_t GPFEN0 = 0x54;
+	constexpr uint32_t GPFEN0 = 0x58;
 	constexpr uint32_t GPFEN1 = 0x5c;
 
 	constexpr uint32_t GPHEN0 = 0x64;
@@ -67,6 +70,9 @@ namespace rpigpio {
 	constexpr uint32_t GPPUDCLK0 = 0x98;
 	constexpr uint32_t GPPUDCLK1 = 0x9c;
 
+	/** Number of GPIO pins **/
+	constexpr unsigned int PIN_COUNT = 54;
+
 	struct PIN_MODE {
 		using type = unsigned;
 		type value;
@@ -86,21 +92,271 @@ namespace rpigpio {
 	inline constexpr PIN_MODE PIN_MODE::ALT4{ 0b011 };
 	inline constexpr PIN_MODE PIN_MODE::ALT5{ 0b010 };
 
+	/**
+	 * Pull-up/down control values, written to GPPUD
+	 */
+	struct PULL_MODE {
+		using type = unsigned;
+		type value;
+
+		constexpr PULL_MODE(type&& value) : value{ std::forward<type>(value) } {}
+
+		constexpr operator type() const { return value; }
+
+		static const PULL_MODE OFF, DOWN, UP;
+	};
+	inline constexpr PULL_MODE PULL_MODE::OFF{ 0b00 };
+	inline constexpr PULL_MODE PULL_MODE::DOWN{ 0b01 };
+	inline constexpr PULL_MODE PULL_MODE::UP{ 0b10 };
+
+	/**
+	 * Time to wait after setting up the pull control and the pull clocks, in nanoseconds.
+	 * The datasheet asks for 150 cycles of the 250 MHz core clock (600ns).
+	 */
+	constexpr uint64_t PULL_SETTLE_NS = 1000;
+
+	/**
+	 * Event detect types, each one is a pair of enable registers.
+	 * Detected events are latched in GPEDS0/GPEDS1.
+	 */
+	struct EDGE_DETECT {
+		uint32_t reg0, reg1;    // Enable register offsets for pins 0-31 and 32-53
+
+		static const EDGE_DETECT RISING, FALLING, HIGH, LOW, ASYNC_RISING, ASYNC_FALLING;
+	};
+	inline constexpr EDGE_DETECT EDGE_DETECT::RISING{ GPREN0, GPREN1 };
+	inline constexpr EDGE_DETECT EDGE_DETECT::FALLING{ GPFEN0, GPFEN1 };
+	inline constexpr EDGE_DETECT EDGE_DETECT::HIGH{ GPHEN0, GPHEN1 };
+	inline constexpr EDGE_DETECT EDGE_DETECT::LOW{ GPLEN0, GPLEN1 };
+	inline constexpr EDGE_DETECT EDGE_DETECT::ASYNC_RISING{ GPAREN0, GPAREN1 };
+	inline constexpr EDGE_DETECT EDGE_DETECT::ASYNC_FALLING{ GPAFEN0, GPAFEN1 };
+
+	/**
+	 * A set of pins, stored as one mask per register bank.
+	 * Bank 0 holds pins 0-31 and bank 1 holds pins 32-53, so a set can be written
+	 * directly to GPSETn/GPCLRn.
+	 */
+	struct PinSet {
+		uint32_t bank0{ 0 };   // Pins 0-31
+		uint32_t bank1{ 0 };   // Pins 32-53
+
+		constexpr PinSet() = default;
+		constexpr PinSet(std::initializer_list<unsigned int> pins)
+		{
+			for (auto pin : pins)
+				add(pin);
+		}
+
+		/**
+		 * Builds a set from register bank masks
+		 * @param bank0_p pins 0-31
+		 * @param bank1_p pins 32-53
+		 */
+		static constexpr PinSet fromBanks(uint32_t bank0_p, uint32_t bank1_p)
+		{
+			PinSet set;
+			set.bank0 = bank0_p;
+			set.bank1 = bank1_p;
+			return set;
+		}
+
+		/**
+		 * Builds a set from a 64-bit mask
+		 * @param mask bit n is pin n
+		 */
+		static constexpr PinSet fromMask(uint64_t mask) { return fromBanks(static_cast<uint32_t>(mask), static_cast<uint32_t>(mask >> 32)); }
+
+		/**
+		 * @return the set as a 64-bit mask, bit n is pin n
+		 */
+		constexpr uint64_t mask() const { return static_cast<uint64_t>(bank1) << 32 | bank0; }
+
+		/**
+		 * Adds a pin to the set
+		 * @param pin pin number
+		 */
+		constexpr PinSet& add(unsigned int pin)
+		{
+			if (pin < 32) bank0 |= 1u << pin;
+			else if (pin < PIN_COUNT) bank1 |= 1u << (pin - 32);
+			return *this;
+		}
+
+		/**
+		 * Removes a pin from the set
+		 * @param pin pin number
+		 */
+		constexpr PinSet& remove(unsigned int pin)
+		{
+			if (pin < 32) bank0 &= ~(1u << pin);
+			else if (pin < PIN_COUNT) bank1 &= ~(1u << (pin - 32));
+			return *this;
+		}
+
+		/**
+		 * Checks if a pin is in the set
+		 * @param pin pin number
+		 */
+		constexpr bool contains(unsigned int pin) const
+		{
+			if (pin < 32) return (bank0 >> pin) & 1u;
+			else if (pin < PIN_COUNT) return (bank1 >> (pin - 32)) & 1u;
+			return false;
+		}
+
+		constexpr bool empty() const { return (bank0 | bank1) == 0; }
+
+		constexpr PinSet operator|(const PinSet& o) const { return fromBanks(bank0 | o.bank0, bank1 | o.bank1); }
+		constexpr PinSet operator&(const PinSet& o) const { return fromBanks(bank0 & o.bank0, bank1 & o.bank1); }
+		constexpr PinSet operator~() const { return fromBanks(~bank0, ~bank1 & ((1u << (PIN_COUNT - 32)) - 1)); }
+		constexpr bool operator==(const PinSet& o) const { return bank0 == o.bank0 && bank1 == o.bank1; }
+		constexpr bool operator!=(const PinSet& o) const { return !(*this == o); }
+	};
+
+	/**
+	 * Batch of pin mode changes, grouped by GPFSEL register.
+	 * Applying it costs one read and one write per affected register, whatever the
+	 * number of pins.
+	 */
+	struct ModeConfig {
+		uint32_t mask[6]{};     // Function select bits to change, per GPFSEL register
+		uint32_t value[6]{};    // New function select bits, per GPFSEL register
+
+		/**
+		 * Adds a pin mode change, replacing any previous change of the same pin
+		 * @param pin pin number
+		 * @param mode pin mode
+		 */
+		constexpr ModeConfig& set(unsigned int pin, PIN_MODE mode)
+		{
+			if (pin < PIN_COUNT) {
+				const unsigned int rnum = pin / 10;
+				const unsigned int offset = (pin % 10) * 3;
+				mask[rnum] |= 0b111u << offset;
+				value[rnum] = (value[rnum] & ~(0b111u << offset)) | (mode << offset);
+			}
+			return *this;
+		}
+
+		/**
+		 * Adds a mode change for several pins
+		 * @param pins pins to change
+		 * @param mode pin mode
+		 */
+		constexpr ModeConfig& set(const PinSet& pins, PIN_MODE mode)
+		{
+			for (unsigned int pin = 0; pin < PIN_COUNT; ++pin)
+				if (pins.contains(pin))
+					set(pin, mode);
+			return *this;
+		}
+	};
+
+	/**
+	 * A set of pull changes, grouped by pull value so that each group is clocked in at once
+	 */
+	struct PullConfig {
+		PinSet pins[3];         // Pins to change, indexed by pull value
+
+		/**
+		 * Adds a pull change, replacing any previous change of the same pin
+		 * @param pin pin number
+		 * @param pull pull value
+		 */
+		constexpr PullConfig& set(unsigned int pin, PULL_MODE pull) { return set(PinSet{ pin }, pull); }
+
+		/**
+		 * Adds a pull change for several pins
+		 * @param pinset pins to change
+		 * @param pull pull value
+		 */
+		constexpr PullConfig& set(const PinSet& pinset, PULL_MODE pull)
+		{
+			for (auto& group : pins)
+				group = group & ~pinset;
+			if (pull < 3)
+				pins[pull] = pins[pull] | pinset;
+			return *this;
+		}
+	};
+
+	/**
+	 * Snapshot of the level of all pins, bit n holds the level of pin n
+	 */
+	struct PinLevels {
+		uint64_t value{ 0 };
+
+		constexpr PinLevels() = default;
+		constexpr explicit PinLevels(uint64_t value_p) : value{ value_p } {}
+		constexpr PinLevels(uint32_t lev0, uint32_t lev1) : value{ (static_cast<uint64_t>(lev1 & ((1u << (PIN_COUNT - 32)) - 1)) << 32) | lev0 } {}
+
+		/**
+		 * Level of a pin
+		 * @param pin pin number
+		 * @return true when HIGH, false when LOW or out of range
+		 */
+		constexpr bool operator[](unsigned int pin) const { return pin < PIN_COUNT && ((value >> pin) & 1u); }
+
+		constexpr uint32_t bank0() const { return static_cast<uint32_t>(value); }
+		constexpr uint32_t bank1() const { return static_cast<uint32_t>(value >> 32); }
+
+		/**
+		 * @return the set of pins that are HIGH
+		 */
+		constexpr PinSet high() const { return PinSet::fromBanks(bank0(), bank1()); }
+
+		constexpr bool operator==(const PinLevels& o) const { return value == o.value; }
+		constexpr bool operator!=(const PinLevels& o) const { return value != o.value; }
+	};
+
+	template<unsigned int N, typename Backend = DevMem> class Pin;
+	template<unsigned int N, typename Backend = DevMem> class OutputPin;
+	template<unsigned int N, typename Backend = DevMem> class InputPin;
+	template<typename Backend = DevMem> class SpiMaster;
+
 	/**
 	 * Library main class.
 	 * Handles GPIO manipulations
+	 * @tparam Backend register page backend, see memory.h
 	 */
-	class GPIO {
+	template<typename Backend = DevMem>
+	class BasicGPIO {
 	private:
-		Bcm2835Periph peripheral{ BCM_GPIO_BASE };   // Peripheral handler
+		Bcm2835Periph<Backend> peripheral;   // Peripheral handler
 		volatile uint32_t* p_base{ nullptr };  // Peripheral memory base pointer;
+		bool fsel_shadowed{ false };           // Whether fsel_shadow is used
+		mutable uint32_t fsel_shadow[6]{};     // Copy of the GPFSEL registers
+		TraceRecorder* recorder{ nullptr };    // Records the output register writes when set, with RPI_GPIO_TRACE
 
 		/**
-		 * Used to access a certain registry
-		 * @param off offset in memory of the registry
-		 * @retrun a reference to the registry
+		 * Reads a register
+		 * @param off offset in memory of the register
+		 * @return the register value
 		 */
-		volatile uint32_t& r(const uint32_t off) const;
+		uint32_t load(const uint32_t off) const
+		{
+			stats::countLoad(off);
+			if constexpr (Backend::emulated) return peripheral.getBackend().load(off);
+			else return p_base[off / 4];
+		}
+
+		/**
+		 * Writes a register
+		 * @param off offset in memory of the register
+		 * @param value new register value
+		 */
+		void store(const uint32_t off, const uint32_t value) const
+		{
+			stats::countStore(off);
+			if constexpr (TRACE_ENABLED) {
+				if (recorder) recorder->record(off, value);
+			}
+			if constexpr (Backend::emulated) peripheral.getBackend().store(off, value);
+			else p_base[off / 4] = value;
+		}
+
+		template<unsigned int, typename> friend class Pin;
+		template<typename> friend class SpiMaster;
 
 		/**
 		 * Type conversion from PIN_MODE to unsigned integer
@@ -120,14 +376,15 @@ namespace rpigpio {
 		/**
 		 * Constructors and operators
 		 */
-		GPIO() = default;
-		~GPIO() = default;
-		GPIO(GPIO&) = delete;
-		GPIO(const GPIO&) = delete;
-		GPIO operator=(GPIO&) = delete;
-		GPIO operator=(const GPIO&) = delete;
-		GPIO(GPIO&&) = default;
-		GPIO& operator=(GPIO&&) = default;
+		BasicGPIO() : peripheral{ BCM_GPIO_BASE } {}
+		explicit BasicGPIO(Backend backend) : peripheral{ BCM_GPIO_BASE, std::move(backend) } {}
+		~BasicGPIO() = default;
+		BasicGPIO(BasicGPIO&) = delete;
+		BasicGPIO(const BasicGPIO&) = delete;
+		BasicGPIO operator=(BasicGPIO&) = delete;
+		BasicGPIO operator=(const BasicGPIO&) = delete;
+		BasicGPIO(BasicGPIO&& o) noexcept;
+		BasicGPIO& operator=(BasicGPIO&& o) noexcept;
 
 		/**
 		 * Opens the GPIO peripheral
@@ -141,6 +398,11 @@ namespace rpigpio {
 		 */
 		bool disconnect(void);
 
+		/**
+		 * @return the register page backend, e.g. the EmuMem giving access to the emulator
+		 */
+		const Backend& getBackend(void) const { return peripheral.getBackend(); }
+
 		/**
 		 * Changes the function of a pin
 		 * @param pin pin number
@@ -148,6 +410,34 @@ namespace rpigpio {
 		 */
 		void pinMode(unsigned int pin, PIN_MODE mode) const;
 
+		/**
+		 * Changes the function of several pins, with one read and one write per
+		 * affected GPFSEL register (no read and no redundant write when shadowed)
+		 * @param config pin mode changes
+		 */
+		void pinMode(const ModeConfig& config) const;
+
+		/**
+		 * Gets the function of a pin, from the shadow copy when enabled
+		 * @param pin pin number
+		 * @return pin mode
+		 */
+		PIN_MODE getMode(unsigned int pin) const;
+
+		/**
+		 * Enables or disables the shadow copy of the GPFSEL registers.
+		 * When enabled, mode queries are answered from the copy and mode changes that
+		 * don't change anything are skipped. Only use it when no other process changes
+		 * pin modes, or call syncModeShadow() after they do.
+		 * @param enable true to enable
+		 */
+		void setModeShadow(bool enable);
+
+		/**
+		 * Reloads the shadow copy of the GPFSEL registers from the peripheral
+		 */
+		void syncModeShadow(void) const;
+
 		/**
 		 * Sets a pin to HIGH
 		 * @param pin pin number
@@ -167,6 +457,35 @@ namespace rpigpio {
 		 */
 		unsigned int pinLev(unsigned int pin) const;
 
+		/**
+		 * Sets and clears several pins at once, with one store per non-zero mask
+		 * @param set0 pins 0-31 to set to HIGH
+		 * @param clr0 pins 0-31 to set to LOW
+		 * @param set1 pins 32-53 to set to HIGH
+		 * @param clr1 pins 32-53 to set to LOW
+		 */
+		void writeMask(uint32_t set0, uint32_t clr0, uint32_t set1, uint32_t clr1) const;
+
+		/**
+		 * Sets and clears several pins at once
+		 * @param high pins to set to HIGH
+		 * @param low pins to set to LOW
+		 */
+		void write(const PinSet& high, const PinSet& low) const;
+
+		/**
+		 * Writes an output frame: each pin of the set takes the level of its bit in levels
+		 * @param pins pins to write
+		 * @param levels pin levels, bits outside of pins are ignored
+		 */
+		void writeFrame(const PinSet& pins, const PinSet& levels) const;
+
+		/**
+		 * Reads the level of all pins at once, with one load per GPLEVn register
+		 * @return snapshot of all pin levels
+		 */
+		PinLevels readAll(void) const;
+
 		/**
 		 * Write a value to a pin
 		 * @param pin pin number
@@ -181,9 +500,204 @@ namespace rpigpio {
 		 */
 		unsigned int digitalRead(unsigned int pin) const;
 
+		/**
+		 * Enables or disables event detection on several pins
+		 * @param pins pins to change
+		 * @param type event detect type
+		 * @param enable true to enable, false to disable
+		 */
+		void edgeDetect(const PinSet& pins, EDGE_DETECT type, bool enable = true) const;
+
+		/**
+		 * Reads the enable registers of an event detect type
+		 * @param type event detect type
+		 * @return pins with the detection enabled
+		 */
+		PinSet edgeDetectEnabled(EDGE_DETECT type) const;
+
+		/**
+		 * Reads the event detect status registers
+		 * @return pins with a pending event
+		 */
+		PinSet readEvents(void) const;
+
+		/**
+		 * Clears pending events (GPEDSn are write-1-to-clear)
+		 * @param pins pins to clear
+		 */
+		void clearEvents(const PinSet& pins) const;
+
+		/**
+		 * Reads and clears pending events on the given pins
+		 * @param pins pins to harvest
+		 * @return pins that had a pending event
+		 */
+		PinSet takeEvents(const PinSet& pins) const;
+
+		/**
+		 * Sets the pull-up/down of a pin
+		 * @param pin pin number
+		 * @param pull pull value
+		 */
+		void pinPull(unsigned int pin, PULL_MODE pull) const;
+
+		/**
+		 * Sets the pull-up/down of several pins.
+		 * Each pull value group takes one GPPUD write, a settle time, one GPPUDCLK write per
+		 * bank and another settle time, instead of one full sequence per pin.
+		 * The pull state can't be read back from the registers.
+		 * @param config pull changes
+		 */
+		void pinPull(const PullConfig& config) const;
+
+		/**
+		 * Records the writes to the output registers (GPFSEL, GPSET, GPCLR), from this
+		 * handler and from the engines driving it. Only recorded when built with
+		 * RPI_GPIO_TRACE (TRACE_ENABLED), ignored otherwise. Not synchronized: set it
+		 * before starting the engines, clear it after stopping them.
+		 * @param recorder_p trace recorder, nullptr to stop recording
+		 */
+		void setRecorder(TraceRecorder* recorder_p) { recorder = recorder_p; }
+
 		/**
 		 * Resets all GPIO parameters
 		 */
 		void reset(void) const;
+
+		/**
+		 * Compile-time pin handles, see Pin
+		 * @tparam N pin number
+		 */
+		template<unsigned int N> Pin<N, Backend> pin(void) const { return Pin<N, Backend>{ *this }; }
+		template<unsigned int N> OutputPin<N, Backend> output(void) const { return OutputPin<N, Backend>{ *this }; }
+		template<unsigned int N> InputPin<N, Backend> input(void) const { return InputPin<N, Backend>{ *this }; }
 	};
+
+	/**
+	 * Compile-time pin handle.
+	 * Register offsets, bit mask and function select slot of the pin are resolved at
+	 * compile time, every access is a single inlined load or store.
+	 * The GPIO handler must stay connected for as long as the pin is used.
+	 * @tparam N pin number
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<unsigned int N, typename Backend>
+	class Pin {
+		static_assert(N < PIN_COUNT, "Pin number out of range!");
+
+	protected:
+		const BasicGPIO<Backend>& gpio;
+
+	public:
+		static constexpr unsigned int number = N;
+		static constexpr uint32_t mask = 1u << (N % 32);
+		static constexpr uint32_t set_reg = N < 32 ? GPSET0 : GPSET1;
+		static constexpr uint32_t clr_reg = N < 32 ? GPCLR0 : GPCLR1;
+		static constexpr uint32_t lev_reg = N < 32 ? GPLEV0 : GPLEV1;
+		static constexpr uint32_t fsel_reg = GPFSEL[N / 10];
+		static constexpr uint32_t fsel_shift = (N % 10) * 3;
+
+		constexpr explicit Pin(const BasicGPIO<Backend>& gpio_p) : gpio{ gpio_p } {}
+
+		/**
+		 * Changes the function of the pin, a read-modify-write of its GPFSEL slot
+		 * (the read comes from the shadow when it is enabled)
+		 * @param mode pin mode
+		 */
+		void mode(PIN_MODE mode) const
+		{
+			const uint32_t current = gpio.fsel_shadowed ? gpio.fsel_shadow[N / 10] : gpio.load(fsel_reg);
+			const uint32_t next = (current & ~(0b111u << fsel_shift)) | (static_cast<uint32_t>(mode) << fsel_shift);
+			if (gpio.fsel_shadowed) {
+				if (next == current) return;
+				gpio.fsel_shadow[N / 10] = next;
+			}
+			gpio.store(fsel_reg, next);
+		}
+
+		/**
+		 * Reads the pin level
+		 * @return true when HIGH
+		 */
+		bool read(void) const { return (gpio.load(lev_reg) & mask) != 0; }
+
+		/**
+		 * Sets the pin to HIGH
+		 */
+		void up(void) const { gpio.store(set_reg, mask); }
+
+		/**
+		 * Sets the pin to LOW
+		 */
+		void down(void) const { gpio.store(clr_reg, mask); }
+
+		/**
+		 * Writes a value to the pin
+		 * @param lev value
+		 */
+		void write(bool lev) const { gpio.store(lev ? set_reg : clr_reg, mask); }
+	};
+
+	/**
+	 * Compile-time output pin, configured as OUTPUT on construction.
+	 * Remembers the last written level, so toggle() is a single store.
+	 * @tparam N pin number
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<unsigned int N, typename Backend>
+	class OutputPin : public Pin<N, Backend> {
+	private:
+		bool level{ false };    // Last written level
+
+	public:
+		explicit OutputPin(const BasicGPIO<Backend>& gpio_p) : Pin<N, Backend>{ gpio_p }
+		{
+			this->mode(PIN_MODE::OUTPUT);
+			level = Pin<N, Backend>::read();
+		}
+
+		void up(void) { Pin<N, Backend>::up(); level = true; }
+		void down(void) { Pin<N, Backend>::down(); level = false; }
+		void write(bool lev) { Pin<N, Backend>::write(lev); level = lev; }
+
+		/**
+		 * Inverts the pin level
+		 */
+		void toggle(void) { write(!level); }
+
+		/**
+		 * @return the last written level
+		 */
+		bool read(void) const { return level; }
+	};
+
+	/**
+	 * Compile-time input pin, configured as INPUT on construction
+	 * @tparam N pin number
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<unsigned int N, typename Backend>
+	class InputPin : public Pin<N, Backend> {
+	private:
+		using Pin<N, Backend>::up;
+		using Pin<N, Backend>::down;
+		using Pin<N, Backend>::write;
+
+	public:
+		explicit InputPin(const BasicGPIO<Backend>& gpio_p) : Pin<N, Backend>{ gpio_p }
+		{
+			this->mode(PIN_MODE::INPUT);
+		}
+	};
+
+	extern template class BasicGPIO<DevMem>;
+	extern template class BasicGPIO<GpioMem>;
+	extern template class BasicGPIO<AnonMem>;
+	extern template class BasicGPIO<FileMem>;
+
+	/** GPIO handlers for each backend **/
+	using GPIO = BasicGPIO<DevMem>;
+	using GPIOMem = BasicGPIO<GpioMem>;
+	using SimGPIO = BasicGPIO<AnonMem>;
+	using FileGPIO = BasicGPIO<FileMem>;
 }
@@ -25,6 +25,10 @@ SOFTWARE.
 */
 #pragma once
 #include <cstdint>
+#include <string>
+#include <utility>
+
+#include <sys/types.h>
 
 namespace rpigpio {
 	/* Constants */
@@ -33,25 +37,99 @@ namespace rpigpio {
 	constexpr uint32_t PAGE_SIZE = (4 * 1024);
 
 	/**
-	 * This class handles access to a peripheral by mapping physical memory to the
-	 * process user memory space
+	 * Register page backends.
+	 * A backend tells Bcm2835Periph where the register page comes from. Every backend
+	 * provides `int open(void) const`, which returns a file descriptor that can be
+	 * mapped (or -1 on failure), and `off_t offset(uint32_t addr) const`, which returns
+	 * the offset at which the page of the given physical address lives in that file.
+	 * The backend is selected at compile time, register accesses never go through a
+	 * virtual call.
+	 * Backends with `shared` set map each physical address once per process: the
+	 * mapping is reference counted and reused by every Bcm2835Periph of that address.
+	 * Backends with `emulated` set also provide `uint32_t load(uint32_t off) const` and
+	 * `void store(uint32_t off, uint32_t value) const`, which handle every register
+	 * access instead of the mapped page (see emulator.h).
+	 */
+
+	/**
+	 * Physical memory through /dev/mem (requires root)
+	 */
+	struct DevMem {
+		static constexpr bool shared = true;
+		static constexpr bool emulated = false;
+
+		int open(void) const;
+		off_t offset(uint32_t addr) const { return addr; }
+	};
+
+	/**
+	 * GPIO register block through /dev/gpiomem (no root required)
+	 */
+	struct GpioMem {
+		static constexpr bool shared = true;
+		static constexpr bool emulated = false;
+
+		int open(void) const;
+		off_t offset(uint32_t) const { return 0; }
+	};
+
+	/**
+	 * Anonymous zero-filled memory page, for running without a Raspberry Pi.
+	 * Every mapping gets a fresh page.
+	 */
+	struct AnonMem {
+		static constexpr bool shared = false;
+		static constexpr bool emulated = false;
+
+		int open(void) const;
+		off_t offset(uint32_t) const { return 0; }
+	};
+
+	/**
+	 * Register image stored in a regular file, created and grown to PAGE_SIZE if needed.
+	 * The image persists between runs and can be shared with other processes.
+	 * Defaults to "rpigpio.img" in the working directory.
 	 */
+	struct FileMem {
+		std::string path;   // Path to the register image
+
+		static constexpr bool shared = false;
+		static constexpr bool emulated = false;
+
+		explicit FileMem(std::string path_p = "rpigpio.img") : path{ std::move(path_p) } {}
 
+		int open(void) const;
+		off_t offset(uint32_t) const { return 0; }
+	};
+
+	/**
+	 * This class handles access to a peripheral by mapping physical memory to the
+	 * process user memory space. Moving transfers the mapping, the moved-from object
+	 * is left unmapped.
+	 * @tparam Backend register page backend (DevMem, GpioMem, AnonMem or FileMem)
+	 */
+	template<typename Backend = DevMem>
 	class Bcm2835Periph {
 	private:
-		const uint32_t addr;         // Physical base address
-		int mem_fd;                 // /dev/mem file descriptor
-		void* mapped;               // Pointer to mapped mémory in the iser space
-		volatile uint32_t* base;    // Public pointer to mapped memory
+		Backend backend;            // Register page backend
+		uint32_t addr;              // Physical base address
+		int mem_fd{ -1 };           // Backend file descriptor
+		void* mapped{ nullptr };    // Pointer to mapped mémory in the iser space
+		volatile uint32_t* base{ nullptr };    // Public pointer to mapped memory
+
+		/**
+		 * Opens the backend file and maps the page, throws on failure
+		 */
+		void mapPage(void);
 
 		/**
-		 * Opens /dev/mem
+		 * Opens the backend file
 		 * @return tru on success, false on failure
 		 */
 		bool openMem(void);
 
 		/**
-		 * Closes /dev/mem
+		 * Closes the backend file
 		 */
 		void closeMem(void);
 
@@ -59,8 +137,9 @@ namespace rpigpio {
 		/**
 		 * Class constructor
 		 * @param addr_p Base address of the peripheral memory
+		 * @param backend_p Register page backend
 		 */
-		explicit Bcm2835Periph(uint32_t addr_p = 0);
+		explicit Bcm2835Periph(uint32_t addr_p = 0, Backend backend_p = Backend{});
 
 		/**
 		 * Destructor
@@ -74,17 +153,19 @@ namespace rpigpio {
 		Bcm2835Periph(const Bcm2835Periph&) = delete;
 		Bcm2835Periph operator=(Bcm2835Periph&) = delete;
 		Bcm2835Periph operator=(const Bcm2835Periph&) = delete;
-		Bcm2835Periph(Bcm2835Periph&&) = default;
-		Bcm2835Periph& operator=(Bcm2835Periph&&) = default;
+		Bcm2835Periph(Bcm2835Periph&& o) noexcept;
+		Bcm2835Periph& operator=(Bcm2835Periph&& o) noexcept;
 
 		/**
-		 * Maps the peripheral memory into the user space memory
+		 * Maps the peripheral memory into the user space memory.
+		 * Shared backends reuse the existing mapping of the address, if any.
+		 * Does nothing if already mapped.
 		 * @return true on success, false on failure
 		 */
 		bool map(void);
 
 		/**
-		 * Unmaps the memory
+		 * Unmaps the memory, shared mappings are released when their last user unmaps them
 		 */
 		void unmap(void);
 
@@ -93,5 +174,15 @@ namespace rpigpio {
 		 * @return pointer to the first 32-bit integer of the mapped memory
 		 */
 		volatile uint32_t* getBase(void) const;
+
+		/**
+		 * @return the register page backend
+		 */
+		const Backend& getBackend(void) const { return backend; }
 	};
+
+	extern template class Bcm2835Periph<DevMem>;
+	extern template class Bcm2835Periph<GpioMem>;
+	extern template class Bcm2835Periph<AnonMem>;
+	extern template class Bcm2835Periph<FileMem>;
 }
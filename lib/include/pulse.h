@@ -0,0 +1,248 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+#include "clock.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace rpigpio {
+	/**
+	 * Pulse statistics of a channel
+	 */
+	struct PulseStats {
+		uint64_t pulses{ 0 };       // Rising edges
+		uint64_t period{ 0 };       // Last period, rising edge to rising edge, in nanoseconds
+		uint64_t high{ 0 };         // Last high time, rising edge to falling edge, in nanoseconds
+		uint64_t mean_period{ 0 };  // Rolling mean of the periods, in nanoseconds
+		uint64_t mean_high{ 0 };    // Rolling mean of the high times, in nanoseconds
+		uint64_t last_edge{ 0 };    // Monotonic time of the last edge, in nanoseconds, tells a stopped signal apart
+
+		/**
+		 * @return rolling frequency in Hz, 0 before the second rising edge
+		 */
+		double frequency(void) const { return mean_period ? 1e9 / static_cast<double>(mean_period) : 0.0; }
+
+		/**
+		 * @return rolling duty cycle, from 0 to 1
+		 */
+		double duty(void) const { return mean_period ? static_cast<double>(mean_high) / static_cast<double>(mean_period) : 0.0; }
+	};
+
+	/**
+	 * Frequency and pulse width counter.
+	 * Every tick samples GPLEV0/GPLEV1 once and XORs the snapshot with the previous one:
+	 * ticks where no registered pin changed cost a load and a compare, otherwise only the
+	 * changed pins are visited. Periods and high times are timestamped at the tick that saw
+	 * the edge, so the resolution is the tick period and a signal is tracked as long as
+	 * each level lasts at least one tick.
+	 * Statistics are published per channel through a sequence lock: readers retry instead
+	 * of blocking, the sampler never waits for them.
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<typename Backend = DevMem>
+	class PulseCounter {
+	public:
+		static constexpr unsigned int MAX_CHANNELS = PIN_COUNT;
+
+	private:
+		struct Channel {
+			unsigned int pin{ 0 };
+			PulseStats state;                       // Owned by the sampling thread
+			uint64_t last_rise{ 0 };                // Owned by the sampling thread, 0 before the first rising edge
+
+			std::atomic<uint32_t> sequence{ 0 };    // Odd while the published statistics are written
+			std::atomic<uint64_t> published[6]{};   // Published copy of state, one word per field
+		};
+
+		const BasicGPIO<Backend>& gpio;
+		Channel channels[MAX_CHANNELS];
+		uint8_t index[PIN_COUNT]{};                 // Channel of each pin
+		unsigned int count{ 0 };
+		uint64_t pins{ 0 };                         // Registered pins
+		uint64_t last{ 0 };                         // Previous snapshot
+		unsigned int smoothing;                     // Rolling means weigh each new value 1/2^smoothing
+		std::chrono::nanoseconds interval;          // Sleep between ticks, 0 to spin
+		std::atomic<bool> running{ false };
+		std::atomic<uint64_t> ticks{ 0 };
+		std::thread sampler;
+
+		static uint64_t average(uint64_t mean, uint64_t value, unsigned int shift)
+		{
+			if (mean == 0) return value;
+			return static_cast<uint64_t>(static_cast<int64_t>(mean) + ((static_cast<int64_t>(value) - static_cast<int64_t>(mean)) >> shift));
+		}
+
+		void publish(Channel& ch)
+		{
+			const uint32_t seq = ch.sequence.load(std::memory_order_relaxed);
+			ch.sequence.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			const uint64_t words[6]{ ch.state.pulses, ch.state.period, ch.state.high, ch.state.mean_period, ch.state.mean_high, ch.state.last_edge };
+			for (unsigned int i = 0; i < 6; ++i)
+				ch.published[i].store(words[i], std::memory_order_relaxed);
+			ch.sequence.store(seq + 2, std::memory_order_release);
+		}
+
+		void run(void)
+		{
+			while (running.load(std::memory_order_relaxed)) {
+				tick();
+				if (interval.count() > 0)
+					std::this_thread::sleep_for(interval);
+			}
+		}
+
+	public:
+		/**
+		 * Class constructor
+		 * @param gpio_p connected GPIO handler
+		 * @param interval_p sleep of the sampler thread between ticks, 0 to spin
+		 * @param smoothing_p the rolling means weigh each new value 1/2^smoothing_p, 0 keeps the last value
+		 */
+		explicit PulseCounter(const BasicGPIO<Backend>& gpio_p, std::chrono::nanoseconds interval_p = std::chrono::nanoseconds{ 0 }, unsigned int smoothing_p = 3)
+			: gpio{ gpio_p }, smoothing{ smoothing_p < 16 ? smoothing_p : 16 }, interval{ interval_p } {}
+
+		~PulseCounter() { stop(); }
+
+		PulseCounter(const PulseCounter&) = delete;
+		PulseCounter& operator=(const PulseCounter&) = delete;
+
+		/**
+		 * Registers a pin, before starting the counter
+		 * @param pin input pin
+		 * @return the channel index, or -1 when the pin is invalid or already registered
+		 */
+		int add(unsigned int pin)
+		{
+			if (count == MAX_CHANNELS || pin >= PIN_COUNT || ((pins >> pin) & 1)) return -1;
+			channels[count].pin = pin;
+			index[pin] = static_cast<uint8_t>(count);
+			pins |= 1ull << pin;
+			last = (last & ~(1ull << pin)) | (gpio.readAll().value & (1ull << pin));
+			return static_cast<int>(count++);
+		}
+
+		/**
+		 * Processes one snapshot
+		 * @param levels levels of all pins
+		 * @param time monotonic time of the snapshot, in nanoseconds
+		 */
+		void sample(const PinLevels& levels, uint64_t time)
+		{
+			uint64_t changed = (levels.value ^ last) & pins;
+			last = levels.value;
+			while (changed) {
+				const unsigned int pin = static_cast<unsigned int>(__builtin_ctzll(changed));
+				changed &= changed - 1;
+
+				Channel& ch = channels[index[pin]];
+				if ((levels.value >> pin) & 1) {
+					if (ch.last_rise) {
+						ch.state.period = time - ch.last_rise;
+						ch.state.mean_period = average(ch.state.mean_period, ch.state.period, smoothing);
+					}
+					ch.last_rise = time;
+					++ch.state.pulses;
+				}
+				else if (ch.last_rise) {
+					ch.state.high = time - ch.last_rise;
+					ch.state.mean_high = average(ch.state.mean_high, ch.state.high, smoothing);
+				}
+				ch.state.last_edge = time;
+				publish(ch);
+			}
+		}
+
+		/**
+		 * Samples the levels once, the clock is only read when a registered pin changed
+		 */
+		void tick(void)
+		{
+			const PinLevels levels{ gpio.readAll() };
+			ticks.fetch_add(1, std::memory_order_relaxed);
+			if ((levels.value ^ last) & pins)
+				sample(levels, monotonicNow());
+		}
+
+		/**
+		 * Starts the sampler thread
+		 */
+		void start(void)
+		{
+			if (running.exchange(true)) return;
+			sampler = std::thread{ &PulseCounter::run, this };
+		}
+
+		/**
+		 * Stops the sampler thread
+		 */
+		void stop(void)
+		{
+			running.store(false);
+			if (sampler.joinable()) sampler.join();
+		}
+
+		/**
+		 * Reads the statistics of a channel, from any thread
+		 * @param channel channel index
+		 * @return a consistent copy of the channel statistics
+		 */
+		PulseStats stats(unsigned int channel) const
+		{
+			const Channel& ch = channels[channel];
+			uint64_t words[6];
+			uint32_t before, after;
+			do {
+				before = ch.sequence.load(std::memory_order_acquire);
+				for (unsigned int i = 0; i < 6; ++i)
+					words[i] = ch.published[i].load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				after = ch.sequence.load(std::memory_order_relaxed);
+			} while ((before & 1) || before != after);
+			return PulseStats{ words[0], words[1], words[2], words[3], words[4], words[5] };
+		}
+
+		/**
+		 * @param channel channel index
+		 * @return pin of the channel
+		 */
+		unsigned int pin(unsigned int channel) const { return channels[channel].pin; }
+
+		/**
+		 * @return number of registered channels
+		 */
+		unsigned int size(void) const { return count; }
+
+		/**
+		 * @return number of ticks
+		 */
+		uint64_t tickCount(void) const { return ticks.load(std::memory_order_relaxed); }
+	};
+}
@@ -0,0 +1,195 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace rpigpio {
+	/**
+	 * Quadrature decoding table, indexed by (previous A/B state << 2) | new A/B state,
+	 * with the A level in bit 1 and the B level in bit 0 of each state.
+	 * Counts up when A leads B (00, 10, 11, 01). Transitions where both A and B changed
+	 * are invalid and count 0.
+	 */
+	constexpr int8_t QUADRATURE_STEP[16] = {
+		 0, -1,  1,  0,
+		 1,  0,  0, -1,
+		-1,  0,  0,  1,
+		 0,  1, -1,  0,
+	};
+	constexpr uint16_t QUADRATURE_INVALID = 0b0001001001001000; // Bit n set for invalid transition n: 00->11, 01->10, 10->01, 11->00
+
+	/**
+	 * Quadrature encoder decoding engine.
+	 * Every tick samples GPLEV0/GPLEV1 once and decodes all the registered encoders from
+	 * that snapshot with QUADRATURE_STEP. Positions are published in atomic counters that
+	 * any thread can read. A sampler thread can tick continuously, or ticks can be driven
+	 * by the caller.
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<typename Backend = DevMem>
+	class QuadratureDecoder {
+	public:
+		static constexpr unsigned int MAX_ENCODERS = PIN_COUNT / 2;
+
+	private:
+		struct Encoder {
+			unsigned int a{ 0 }, b{ 0 };            // A and B pins
+			unsigned int state{ 0 };                // Last A/B state
+			int64_t count{ 0 };                     // Position, owned by the sampling thread
+			uint64_t invalid{ 0 };                  // Invalid transitions, owned by the sampling thread
+			std::atomic<int64_t> position{ 0 };     // Published position
+			std::atomic<uint64_t> errors{ 0 };      // Published invalid transitions
+		};
+
+		const BasicGPIO<Backend>& gpio;
+		Encoder encoders[MAX_ENCODERS];
+		unsigned int count{ 0 };
+		std::chrono::nanoseconds interval;          // Sleep between ticks, 0 to spin
+		std::atomic<bool> running{ false };
+		std::atomic<uint64_t> ticks{ 0 };
+		std::thread sampler;
+
+		static unsigned int stateOf(uint64_t levels, const Encoder& enc)
+		{
+			return static_cast<unsigned int>(((levels >> enc.a) & 1) << 1 | ((levels >> enc.b) & 1));
+		}
+
+		void run(void)
+		{
+			while (running.load(std::memory_order_relaxed)) {
+				tick();
+				if (interval.count() > 0)
+					std::this_thread::sleep_for(interval);
+			}
+		}
+
+	public:
+		/**
+		 * Class constructor
+		 * @param gpio_p connected GPIO handler
+		 * @param interval_p sleep of the sampler thread between ticks, 0 to spin
+		 */
+		explicit QuadratureDecoder(const BasicGPIO<Backend>& gpio_p, std::chrono::nanoseconds interval_p = std::chrono::nanoseconds{ 0 })
+			: gpio{ gpio_p }, interval{ interval_p } {}
+
+		~QuadratureDecoder() { stop(); }
+
+		QuadratureDecoder(const QuadratureDecoder&) = delete;
+		QuadratureDecoder& operator=(const QuadratureDecoder&) = delete;
+
+		/**
+		 * Registers an encoder, before starting the decoder
+		 * @param a A pin
+		 * @param b B pin
+		 * @return the encoder index, or -1 when all the encoders are used or a pin is invalid
+		 */
+		int add(unsigned int a, unsigned int b)
+		{
+			if (count == MAX_ENCODERS || a >= PIN_COUNT || b >= PIN_COUNT || a == b) return -1;
+			Encoder& enc = encoders[count];
+			enc.a = a;
+			enc.b = b;
+			enc.state = stateOf(gpio.readAll().value, enc);
+			return static_cast<int>(count++);
+		}
+
+		/**
+		 * Decodes one snapshot
+		 * @param levels levels of all pins
+		 */
+		void decode(const PinLevels& levels)
+		{
+			for (unsigned int i = 0; i < count; ++i) {
+				Encoder& enc = encoders[i];
+				const unsigned int state = stateOf(levels.value, enc);
+				if (state == enc.state) continue;
+
+				const unsigned int transition = enc.state << 2 | state;
+				enc.state = state;
+				if ((QUADRATURE_INVALID >> transition) & 1) {
+					enc.errors.store(++enc.invalid, std::memory_order_relaxed);
+					continue;
+				}
+				enc.count += QUADRATURE_STEP[transition];
+				enc.position.store(enc.count, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		 * Samples the levels once and decodes them
+		 */
+		void tick(void)
+		{
+			decode(gpio.readAll());
+			ticks.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Starts the sampler thread
+		 */
+		void start(void)
+		{
+			if (running.exchange(true)) return;
+			sampler = std::thread{ &QuadratureDecoder::run, this };
+		}
+
+		/**
+		 * Stops the sampler thread
+		 */
+		void stop(void)
+		{
+			running.store(false);
+			if (sampler.joinable()) sampler.join();
+		}
+
+		/**
+		 * @param encoder encoder index
+		 * @return position of the encoder, in steps
+		 */
+		int64_t position(unsigned int encoder) const { return encoders[encoder].position.load(std::memory_order_relaxed); }
+
+		/**
+		 * @param encoder encoder index
+		 * @return number of invalid transitions of the encoder, both A and B changed between two ticks
+		 */
+		uint64_t errors(unsigned int encoder) const { return encoders[encoder].errors.load(std::memory_order_relaxed); }
+
+		/**
+		 * @return number of registered encoders
+		 */
+		unsigned int size(void) const { return count; }
+
+		/**
+		 * @return number of ticks
+		 */
+		uint64_t tickCount(void) const { return ticks.load(std::memory_order_relaxed); }
+	};
+}
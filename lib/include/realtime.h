@@ -0,0 +1,109 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+
+#include <cstddef>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace rpigpio {
+	/**
+	 * Real-time settings of a thread
+	 */
+	struct RealtimeConfig {
+		int cpu{ -1 };                      // CPU the thread is pinned to, -1 picks the first isolated CPU (none if no CPU is isolated)
+		int priority{ 50 };                 // SCHED_FIFO priority, from 1 to 99, 0 keeps the current policy
+		bool lock_memory{ true };           // Lock the current and future pages of the process in RAM
+		size_t stack_prefault{ 64 * 1024 }; // Bytes of stack touched ahead of time
+	};
+
+	/**
+	 * Runs the calling thread in real-time conditions for the lifetime of the object: pinned
+	 * to one CPU, scheduled with SCHED_FIFO, with memory locked and the stack pre-faulted, so
+	 * a timing-sensitive loop doesn't take page faults or get preempted by ordinary threads.
+	 * Each step is applied independently, most need root or CAP_SYS_NICE/CAP_IPC_LOCK: check
+	 * pinned(), scheduled() and locked() to know which ones took effect.
+	 * The previous affinity and policy are restored on destruction, which must happen on the
+	 * same thread. Memory locking is process-wide: it is shared by the contexts of all
+	 * threads and only released when the last one is destroyed. A lock taken with mlockall
+	 * outside of RealtimeContext is released too at that point.
+	 */
+	class RealtimeContext {
+	private:
+		cpu_set_t previous_affinity;
+		int previous_policy{ SCHED_OTHER };
+		sched_param previous_param{};
+		int cpu_index{ -1 };
+		bool is_pinned{ false };
+		bool is_scheduled{ false };
+		bool is_locked{ false };
+
+	public:
+		/**
+		 * Applies the settings to the calling thread
+		 * @param config real-time settings
+		 */
+		explicit RealtimeContext(const RealtimeConfig& config = {});
+		RealtimeContext(const RealtimeContext&) = delete;
+		RealtimeContext& operator=(const RealtimeContext&) = delete;
+		~RealtimeContext();
+
+		/**
+		 * Reads the level registers of a handler once, so the first access of the real-time
+		 * loop doesn't fault. This is a single-page touch: only the register page holding
+		 * GPLEV0/GPLEV1 is faulted in, the code and data of the loop are left to lock_memory.
+		 * @param gpio connected GPIO handler
+		 */
+		template<typename Backend>
+		void prefault(const BasicGPIO<Backend>& gpio) const
+		{
+			(void)gpio.readAll();
+		}
+
+		/**
+		 * @return CPU the thread is pinned to, -1 if not pinned
+		 */
+		int cpu(void) const { return is_pinned ? cpu_index : -1; }
+
+		bool pinned(void) const { return is_pinned; }
+		bool scheduled(void) const { return is_scheduled; }
+		bool locked(void) const { return is_locked; }
+
+		/**
+		 * Reads the isolated CPUs of the kernel command line (isolcpus=)
+		 * @return first isolated CPU, -1 if none
+		 */
+		static int isolatedCpu(void);
+
+		/**
+		 * Touches stack pages below the current frame
+		 * @param bytes size of the stack region to touch
+		 */
+		static void prefaultStack(size_t bytes);
+	};
+}
@@ -0,0 +1,338 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace rpigpio {
+	/**
+	 * Remote access protocol.
+	 * Clients send fixed-size RemoteRequest messages over a SOCK_SEQPACKET Unix socket,
+	 * the server answers each one with a RemoteResponse. A request carries up to
+	 * REMOTE_MAX_OPS operations, executed in order. Masks hold bank 0 in the low 32 bits
+	 * and bank 1 in the high 32 bits.
+	 */
+	constexpr uint32_t REMOTE_MAGIC = 0x52475052; // "RPGR"
+	constexpr uint32_t REMOTE_MAX_OPS = 16;
+
+	enum class RemoteOpCode : uint32_t {
+		NOP,
+		WRITE,          // Set the pins of 'high', clear the pins of 'low'
+		READ,           // Read all levels, returned in the op's response value
+		MODE,           // Set the mode of pin 'arg' to 'high'
+		TAKE_EVENTS,    // Read and clear the events of the pins of 'high', returned in the op's response value
+	};
+
+	enum class RemoteStatus : uint32_t {
+		OK,
+		BAD_MAGIC,
+		BAD_COUNT,
+		BAD_OP,
+	};
+
+	struct RemoteOp {
+		RemoteOpCode code;
+		uint32_t arg;
+		uint64_t high;
+		uint64_t low;
+	};
+
+	/**
+	 * Request message. The op builders return the index of the added op, and throw
+	 * std::length_error when the request already holds REMOTE_MAX_OPS ops.
+	 */
+	struct RemoteRequest {
+		uint32_t magic{ REMOTE_MAGIC };
+		uint32_t seq{ 0 };
+		uint32_t count{ 0 };    // Number of ops
+		uint32_t reserved{ 0 };
+		RemoteOp ops[REMOTE_MAX_OPS]{};
+
+		bool full(void) const { return count >= REMOTE_MAX_OPS; }
+		void clear(void) { count = 0; }
+
+		/**
+		 * Adds a write
+		 * @param high pins set to HIGH
+		 * @param low pins set to LOW
+		 * @return index of the op
+		 */
+		uint32_t write(const PinSet& high, const PinSet& low) { return add({ RemoteOpCode::WRITE, 0, toMask(high), toMask(low) }); }
+
+		/**
+		 * Adds a snapshot of all levels
+		 * @return index of the op, and of its levels in the response
+		 */
+		uint32_t read(void) { return add({ RemoteOpCode::READ, 0, 0, 0 }); }
+
+		/**
+		 * Adds a mode change
+		 * @param pin pin number
+		 * @param mode new mode
+		 * @return index of the op
+		 */
+		uint32_t mode(unsigned int pin, PIN_MODE mode) { return add({ RemoteOpCode::MODE, pin, static_cast<uint64_t>(mode), 0 }); }
+
+		/**
+		 * Adds a read and clear of pin events
+		 * @param pins pins to check
+		 * @return index of the op, and of its events in the response
+		 */
+		uint32_t takeEvents(const PinSet& pins) { return add({ RemoteOpCode::TAKE_EVENTS, 0, toMask(pins), 0 }); }
+
+		static constexpr uint64_t toMask(const PinSet& pins) { return static_cast<uint64_t>(pins.bank1) << 32 | pins.bank0; }
+		static constexpr PinSet toPins(uint64_t mask) { return PinSet::fromBanks(static_cast<uint32_t>(mask), static_cast<uint32_t>(mask >> 32)); }
+
+	private:
+		uint32_t add(const RemoteOp& op)
+		{
+			if (full()) throw std::length_error{ "Remote request full, at most REMOTE_MAX_OPS ops" };
+			ops[count] = op;
+			return count++;
+		}
+	};
+
+	struct RemoteResponse {
+		uint32_t seq;           // Sequence number of the request
+		RemoteStatus status;
+		uint32_t count;         // Number of ops executed
+		uint32_t reserved;
+		uint64_t values[REMOTE_MAX_OPS];    // Result of each op, 0 for ops without one
+	};
+
+	/**
+	 * Executes a request. Every field of the response is written, values of ops that
+	 * weren't executed or have no result are 0.
+	 * @param gpio connected GPIO handler
+	 * @param req request
+	 * @param resp response, filled in
+	 */
+	template<typename Backend>
+	void execute(const BasicGPIO<Backend>& gpio, const RemoteRequest& req, RemoteResponse& resp)
+	{
+		// the whole response is sent back, nothing of a previous request may remain in it
+		resp.seq = req.seq;
+		resp.count = 0;
+		resp.reserved = 0;
+		std::fill(std::begin(resp.values), std::end(resp.values), 0);
+		if (req.magic != REMOTE_MAGIC) {
+			resp.status = RemoteStatus::BAD_MAGIC;
+			return;
+		}
+		if (req.count > REMOTE_MAX_OPS) {
+			resp.status = RemoteStatus::BAD_COUNT;
+			return;
+		}
+
+		resp.status = RemoteStatus::OK;
+		for (uint32_t i = 0; i < req.count; ++i) {
+			const RemoteOp& op = req.ops[i];
+			switch (op.code) {
+			case RemoteOpCode::NOP:
+				break;
+			case RemoteOpCode::WRITE:
+				gpio.write(RemoteRequest::toPins(op.high), RemoteRequest::toPins(op.low));
+				break;
+			case RemoteOpCode::READ:
+				resp.values[i] = gpio.readAll().value;
+				break;
+			case RemoteOpCode::MODE:
+				if (op.arg >= PIN_COUNT || op.high > 0b111) {
+					resp.status = RemoteStatus::BAD_OP;
+					return;
+				}
+				gpio.pinMode(op.arg, PIN_MODE{ static_cast<PIN_MODE::type>(op.high) });
+				break;
+			case RemoteOpCode::TAKE_EVENTS:
+				resp.values[i] = RemoteRequest::toMask(gpio.takeEvents(RemoteRequest::toPins(op.high)));
+				break;
+			default:
+				resp.status = RemoteStatus::BAD_OP;
+				return;
+			}
+			++resp.count;
+		}
+	}
+
+	/**
+	 * Server statistics
+	 */
+	struct RemoteStats {
+		uint64_t requests{ 0 };     // Number of requests answered
+		uint64_t ops{ 0 };          // Number of ops executed
+		uint64_t connections{ 0 };  // Number of accepted connections
+	};
+
+	/**
+	 * Serves requests on a Unix socket, from a single thread using epoll
+	 */
+	class RemoteServer {
+	private:
+		std::string path;
+		int listen_fd{ -1 };
+		int epoll_fd{ -1 };
+		RemoteStats stats;
+
+		/**
+		 * Waits for requests, accepting new connections
+		 * @param ready filled with clients that have pending requests
+		 * @param max size of ready
+		 * @param timeout timeout in milliseconds
+		 * @return number of ready clients
+		 */
+		int wait(int* ready, int max, int timeout);
+
+		/**
+		 * Answers all pending requests of a client, closes it on errors and hang ups
+		 */
+		template<typename Backend>
+		void answer(const BasicGPIO<Backend>& gpio, int fd)
+		{
+			RemoteRequest req;
+			RemoteResponse resp{};
+			while (true) {
+				const ssize_t len = receive(fd, req);
+				if (len == 0) return;   // nothing pending
+				if (len != static_cast<ssize_t>(sizeof(RemoteRequest))) {
+					drop(fd);
+					return;
+				}
+				execute(gpio, req, resp);
+				++stats.requests;
+				stats.ops += resp.count;
+				if (!reply(fd, resp)) {
+					drop(fd);
+					return;
+				}
+			}
+		}
+
+		ssize_t receive(int fd, RemoteRequest& req);
+		bool reply(int fd, const RemoteResponse& resp);
+		void drop(int fd);
+
+	public:
+		/**
+		 * Creates the socket, replacing a stale one. Throws when the path exists and isn't a
+		 * socket, or when a server still accepts connections on it. The socket file is
+		 * created with its permissions set, the process umask is changed during the bind.
+		 * @param path socket path
+		 * @param mode socket file permissions
+		 */
+		explicit RemoteServer(const std::string& path, mode_t mode = 0660);
+		~RemoteServer();
+
+		RemoteServer(const RemoteServer&) = delete;
+		RemoteServer& operator=(const RemoteServer&) = delete;
+
+		/**
+		 * Serves requests until stop is set
+		 * @param gpio connected GPIO handler
+		 * @param stop set to true to stop serving, checked every 100ms
+		 * @return server statistics
+		 */
+		template<typename Backend>
+		const RemoteStats& serve(const BasicGPIO<Backend>& gpio, const std::atomic<bool>& stop)
+		{
+			int ready[64];
+			while (!stop.load(std::memory_order_relaxed)) {
+				const int n = wait(ready, 64, 100);
+				for (int i = 0; i < n; ++i)
+					answer(gpio, ready[i]);
+			}
+			return stats;
+		}
+	};
+
+	/**
+	 * Client side of the remote access protocol
+	 */
+	class RemoteClient {
+	private:
+		int fd{ -1 };
+		uint32_t seq{ 0 };
+
+	public:
+		RemoteClient() = default;
+		~RemoteClient();
+
+		RemoteClient(const RemoteClient&) = delete;
+		RemoteClient& operator=(const RemoteClient&) = delete;
+
+		/**
+		 * Connects to a server
+		 * @param path socket path
+		 * @return true on success, false otherwise
+		 */
+		bool connect(const std::string& path);
+
+		/**
+		 * Closes the connection
+		 */
+		void disconnect(void);
+
+		/**
+		 * Sends a request and waits for its response, throws on I/O errors and failed requests
+		 * @param req request, its sequence number is set
+		 * @param resp response
+		 */
+		void transact(RemoteRequest& req, RemoteResponse& resp);
+
+		/**
+		 * Sets and clears pins in one request
+		 * @param high pins set to HIGH
+		 * @param low pins set to LOW
+		 */
+		void write(const PinSet& high, const PinSet& low);
+
+		/**
+		 * @return a snapshot of all levels
+		 */
+		PinLevels readAll(void);
+
+		/**
+		 * Sets the mode of a pin
+		 * @param pin pin number
+		 * @param mode new mode
+		 */
+		void pinMode(unsigned int pin, PIN_MODE mode);
+
+		/**
+		 * Reads and clears pin events
+		 * @param pins pins to check
+		 * @return pins with a pending event
+		 */
+		PinSet takeEvents(const PinSet& pins);
+	};
+}
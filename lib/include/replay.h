@@ -0,0 +1,82 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+#include "trace.h"
+#include "waveform.h"
+
+#include <string>
+#include <vector>
+
+namespace rpigpio {
+	/**
+	 * Replays a trace file with its original timing.
+	 * The trace is streamed in chunks, each write is issued at its recorded time
+	 * relative to the start of the replay, waiting with the player's hybrid sleep/spin.
+	 * GPSET/GPCLR records are replayed as mask writes and GPFSEL records as a ModeConfig
+	 * covering the whole register.
+	 * @param gpio connected GPIO handler
+	 * @param path trace file
+	 * @param player waits for each write
+	 * @param lead delay between the call and the first write, in nanoseconds
+	 * @return deviation from the recorded timing of every write
+	 */
+	template<typename Backend>
+	PlaybackStats replayTrace(const BasicGPIO<Backend>& gpio, const std::string& path, const WaveformPlayer& player = WaveformPlayer{}, uint64_t lead = 1000000)
+	{
+		TraceReader reader{ path };
+		std::vector<int64_t> deviations;
+		deviations.reserve(static_cast<size_t>(reader.info().count));
+
+		TraceRecord chunk[4096];
+		const uint64_t start = monotonicNow() + lead;
+		for (size_t n; (n = reader.read(chunk, 4096)) != 0;) {
+			for (size_t i = 0; i < n; ++i) {
+				const TraceRecord& record = chunk[i];
+				const uint64_t deadline = start + record.time;
+				player.waitUntil(deadline);
+
+				switch (record.off) {
+				case GPSET0: gpio.writeMask(record.value, 0, 0, 0); break;
+				case GPSET1: gpio.writeMask(0, 0, record.value, 0); break;
+				case GPCLR0: gpio.writeMask(0, record.value, 0, 0); break;
+				case GPCLR1: gpio.writeMask(0, 0, 0, record.value); break;
+				default:
+					if (record.off <= GPFSEL[5] && record.off % 4 == 0) {
+						ModeConfig config;
+						config.mask[record.off / 4] = 0x3FFFFFFF;
+						config.value[record.off / 4] = record.value & 0x3FFFFFFF;
+						gpio.pinMode(config);
+					}
+					break;
+				}
+				deviations.push_back(static_cast<int64_t>(monotonicNow() - deadline));
+			}
+		}
+
+		return PlaybackStats::compute(deviations);
+	}
+}
@@ -0,0 +1,215 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace rpigpio {
+	/**
+	 * Bounded lock-free single-producer single-consumer ring buffer.
+	 * One thread pushes, one other thread pops. The capacity is rounded up to a power
+	 * of two. When the ring is full, pushed elements are dropped and counted.
+	 */
+	template<typename T>
+	class SpscRing {
+	private:
+		static constexpr size_t CACHE_LINE = 64;
+
+		std::unique_ptr<T[]> buffer;    // Ring storage
+		size_t mask;                    // Capacity - 1
+		alignas(CACHE_LINE) std::atomic<size_t> head{ 0 };     // Next slot to write, owned by the producer
+		alignas(CACHE_LINE) std::atomic<size_t> tail{ 0 };     // Next slot to read, owned by the consumer
+		alignas(CACHE_LINE) std::atomic<uint64_t> drops{ 0 };  // Elements dropped because the ring was full
+
+		static constexpr size_t roundUp(size_t n)
+		{
+			size_t p = 1;
+			while (p < n) p <<= 1;
+			return p;
+		}
+
+	public:
+		/**
+		 * Class constructor
+		 * @param capacity minimum number of elements the ring can hold
+		 */
+		explicit SpscRing(size_t capacity) : buffer{ new T[roundUp(capacity)] }, mask{ roundUp(capacity) - 1 } {}
+
+		SpscRing(const SpscRing&) = delete;
+		SpscRing& operator=(const SpscRing&) = delete;
+
+		/**
+		 * Pushes an element, producer side
+		 * @param value element
+		 * @return false when the ring was full and the element was dropped
+		 */
+		bool push(const T& value)
+		{
+			const size_t h = head.load(std::memory_order_relaxed);
+			if (h - tail.load(std::memory_order_acquire) > mask) {
+				drops.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			buffer[h & mask] = value;
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * Pops up to max elements, consumer side
+		 * @param out destination array
+		 * @param max maximum number of elements
+		 * @return number of elements popped
+		 */
+		size_t pop(T* out, size_t max)
+		{
+			const size_t t = tail.load(std::memory_order_relaxed);
+			size_t n = head.load(std::memory_order_acquire) - t;
+			if (n > max) n = max;
+			for (size_t i = 0; i < n; ++i)
+				out[i] = buffer[(t + i) & mask];
+			tail.store(t + n, std::memory_order_release);
+			return n;
+		}
+
+		/**
+		 * @return number of elements waiting to be popped
+		 */
+		size_t size(void) const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+		/**
+		 * @return maximum number of elements the ring can hold
+		 */
+		size_t capacity(void) const { return mask + 1; }
+
+		/**
+		 * @return number of elements dropped because the ring was full
+		 */
+		uint64_t dropped(void) const { return drops.load(std::memory_order_relaxed); }
+	};
+
+	/**
+	 * Bounded lock-free multi-producer single-consumer ring buffer.
+	 * Any number of threads push, one thread pops. Each slot carries a sequence number
+	 * telling whether it is free, being written or ready, so producers only contend on
+	 * the head index. The capacity is rounded up to a power of two. Pushing to a full
+	 * ring fails, the caller decides whether to retry.
+	 */
+	template<typename T>
+	class MpscRing {
+	private:
+		static constexpr size_t CACHE_LINE = 64;
+
+		struct Cell {
+			std::atomic<size_t> seq;    // Equal to the position when free, to the position + 1 when ready
+			T value;
+		};
+
+		std::unique_ptr<Cell[]> cells;  // Ring storage
+		size_t mask;                    // Capacity - 1
+		alignas(CACHE_LINE) std::atomic<size_t> head{ 0 };     // Next slot to claim, shared by the producers
+		alignas(CACHE_LINE) std::atomic<size_t> tail{ 0 };     // Next slot to read, owned by the consumer
+
+		static constexpr size_t roundUp(size_t n)
+		{
+			size_t p = 1;
+			while (p < n) p <<= 1;
+			return p;
+		}
+
+	public:
+		/**
+		 * Class constructor
+		 * @param capacity minimum number of elements the ring can hold
+		 */
+		explicit MpscRing(size_t capacity) : cells{ new Cell[roundUp(capacity)] }, mask{ roundUp(capacity) - 1 }
+		{
+			for (size_t i = 0; i <= mask; ++i)
+				cells[i].seq.store(i, std::memory_order_relaxed);
+		}
+
+		MpscRing(const MpscRing&) = delete;
+		MpscRing& operator=(const MpscRing&) = delete;
+
+		/**
+		 * Pushes an element, producer side
+		 * @param value element
+		 * @return false when the ring was full
+		 */
+		bool push(const T& value)
+		{
+			size_t pos = head.load(std::memory_order_relaxed);
+			while (true) {
+				Cell& cell = cells[pos & mask];
+				const size_t seq = cell.seq.load(std::memory_order_acquire);
+				if (seq == pos) {
+					if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						cell.value = value;
+						cell.seq.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (static_cast<std::ptrdiff_t>(seq - pos) < 0) return false;   // not popped yet since the previous lap
+				else pos = head.load(std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		 * Pops up to max elements, consumer side.
+		 * Stops at the first slot still being written.
+		 * @param out destination array
+		 * @param max maximum number of elements
+		 * @return number of elements popped
+		 */
+		size_t pop(T* out, size_t max)
+		{
+			const size_t t = tail.load(std::memory_order_relaxed);
+			size_t n = 0;
+			for (; n < max; ++n) {
+				Cell& cell = cells[(t + n) & mask];
+				if (cell.seq.load(std::memory_order_acquire) != t + n + 1) break;
+				// moved out, a free slot doesn't keep resources of the element alive
+				out[n] = std::move(cell.value);
+				cell.seq.store(t + n + mask + 1, std::memory_order_release);
+			}
+			tail.store(t + n, std::memory_order_relaxed);
+			return n;
+		}
+
+		/**
+		 * @return number of claimed slots not popped yet, approximate while producers run
+		 */
+		size_t size(void) const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed); }
+
+		/**
+		 * @return maximum number of elements the ring can hold
+		 */
+		size_t capacity(void) const { return mask + 1; }
+	};
+}
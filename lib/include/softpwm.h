@@ -0,0 +1,218 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+#include "waveform.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace rpigpio {
+	/**
+	 * One PWM period, compiled from the duty cycle of every channel.
+	 * All channels go HIGH at the start of the period, then each distinct duty cycle
+	 * gets one step clearing all the channels that share it.
+	 */
+	struct PwmSchedule {
+		struct Step {
+			uint32_t tick;  // Tick of the period at which the pins go LOW
+			PinSet clr;     // Pins going LOW
+		};
+
+		PinSet on;                  // Pins set to HIGH at the start of the period
+		PinSet off;                 // Pins set to LOW at the start of the period
+		std::vector<Step> steps;    // Sorted by tick
+
+		/**
+		 * Rebuilds the schedule
+		 * @param channels enabled channels
+		 * @param duties duty cycle of every pin, in ticks
+		 * @param resolution number of ticks per period
+		 */
+		void build(const PinSet& channels, const uint32_t* duties, uint32_t resolution);
+	};
+
+	/**
+	 * Multi-channel software PWM, driven by one thread.
+	 * Every step costs at most one store per register bank, whatever the number of
+	 * channels. Duty cycles can be changed from any thread without locking, the new
+	 * values are picked up at the start of the next period.
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<typename Backend = DevMem>
+	class SoftPwm {
+	private:
+		const BasicGPIO<Backend>& gpio;
+		const uint64_t period;                      // Period, in nanoseconds
+		const uint32_t resolution;                  // Ticks per period
+		std::atomic<uint32_t> duties[PIN_COUNT]{};  // Duty cycle of every pin, in ticks
+		std::atomic<uint64_t> channels{ 0 };        // Enabled channels, bit n is pin n
+		std::atomic<uint64_t> generation{ 0 };      // Incremented on every change
+		std::atomic<uint64_t> periods{ 0 };         // Periods played
+		std::atomic<uint64_t> overruns{ 0 };        // Periods that started late
+		std::atomic<bool> running{ false };
+		WaveformPlayer timer;
+		std::thread worker;
+
+		static PinSet toPinSet(uint64_t mask) { return PinSet::fromBanks(static_cast<uint32_t>(mask), static_cast<uint32_t>(mask >> 32)); }
+
+		void run(void)
+		{
+			PwmSchedule schedule;
+			uint32_t snapshot[PIN_COUNT];
+			uint64_t seen{ ~0ull };
+			PinSet previous;
+			const uint64_t tick{ period / resolution };
+
+			uint64_t start{ monotonicNow() + period };
+			while (running.load(std::memory_order_relaxed)) {
+				if (const uint64_t gen{ generation.load(std::memory_order_acquire) }; gen != seen) {
+					seen = gen;
+					const PinSet current{ toPinSet(channels.load(std::memory_order_relaxed)) };
+					for (unsigned int pin = 0; pin < PIN_COUNT; ++pin)
+						snapshot[pin] = duties[pin].load(std::memory_order_relaxed);
+					schedule.build(current, snapshot, resolution);
+					// disabled channels are left LOW
+					schedule.off = schedule.off | (previous & ~current);
+					previous = current;
+				}
+
+				timer.waitUntil(start);
+				gpio.write(schedule.on, schedule.off);
+				for (const auto& step : schedule.steps) {
+					timer.waitUntil(start + step.tick * tick);
+					gpio.write(PinSet{}, step.clr);
+				}
+				periods.fetch_add(1, std::memory_order_relaxed);
+
+				start += period;
+				if (const uint64_t now{ monotonicNow() }; now > start) {
+					overruns.fetch_add(1, std::memory_order_relaxed);
+					start = now;
+				}
+			}
+
+			gpio.write(PinSet{}, previous);
+		}
+
+	public:
+		/**
+		 * Class constructor
+		 * @param gpio_p connected GPIO handler
+		 * @param period_p PWM period, in nanoseconds
+		 * @param resolution_p number of duty cycle steps per period
+		 */
+		SoftPwm(const BasicGPIO<Backend>& gpio_p, uint64_t period_p = 1000000, uint32_t resolution_p = 100)
+			: gpio{ gpio_p }, period{ period_p }, resolution{ resolution_p ? resolution_p : 1 } {}
+
+		~SoftPwm() { stop(); }
+
+		SoftPwm(const SoftPwm&) = delete;
+		SoftPwm& operator=(const SoftPwm&) = delete;
+
+		/**
+		 * Calibrates the spin window of the timer, see WaveformPlayer::calibrate
+		 */
+		void calibrate(void) { timer.calibrate(); }
+
+		/**
+		 * Starts the PWM thread
+		 */
+		void start(void)
+		{
+			if (running.exchange(true)) return;
+			worker = std::thread{ &SoftPwm::run, this };
+		}
+
+		/**
+		 * Stops the PWM thread, all channels are left LOW
+		 */
+		void stop(void)
+		{
+			running.store(false);
+			if (worker.joinable()) worker.join();
+		}
+
+		/**
+		 * Enables a channel, the pin must be configured as OUTPUT
+		 * @param pin pin number
+		 * @param duty duty cycle, in ticks
+		 */
+		void enable(unsigned int pin, uint32_t duty)
+		{
+			if (pin >= PIN_COUNT) return;
+			duties[pin].store(duty, std::memory_order_relaxed);
+			channels.fetch_or(1ull << pin, std::memory_order_relaxed);
+			generation.fetch_add(1, std::memory_order_release);
+		}
+
+		/**
+		 * Disables a channel, the pin is left LOW
+		 * @param pin pin number
+		 */
+		void disable(unsigned int pin)
+		{
+			if (pin >= PIN_COUNT) return;
+			channels.fetch_and(~(1ull << pin), std::memory_order_relaxed);
+			generation.fetch_add(1, std::memory_order_release);
+		}
+
+		/**
+		 * Changes the duty cycle of a channel, without locking
+		 * @param pin pin number
+		 * @param duty duty cycle, in ticks (0 to resolution)
+		 */
+		void setDuty(unsigned int pin, uint32_t duty)
+		{
+			if (pin >= PIN_COUNT) return;
+			duties[pin].store(duty, std::memory_order_relaxed);
+			generation.fetch_add(1, std::memory_order_release);
+		}
+
+		/**
+		 * @param pin pin number
+		 * @return duty cycle of the channel, in ticks
+		 */
+		uint32_t getDuty(unsigned int pin) const { return pin < PIN_COUNT ? duties[pin].load(std::memory_order_relaxed) : 0; }
+
+		/**
+		 * @return number of ticks per period
+		 */
+		uint32_t getResolution(void) const { return resolution; }
+
+		/**
+		 * @return number of periods played
+		 */
+		uint64_t periodCount(void) const { return periods.load(std::memory_order_relaxed); }
+
+		/**
+		 * @return number of periods that started late
+		 */
+		uint64_t overrunCount(void) const { return overruns.load(std::memory_order_relaxed); }
+	};
+}
@@ -0,0 +1,213 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+#include "clock.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rpigpio {
+	constexpr unsigned int SPI_NO_PIN = PIN_COUNT;     // No MISO, write-only bus
+
+	/**
+	 * Bit-banged SPI bus configuration
+	 */
+	struct SpiConfig {
+		unsigned int cs;                    // Chip select pin, active LOW
+		unsigned int sclk;                  // Clock pin
+		unsigned int mosi;                  // Master out pin
+		unsigned int miso{ SPI_NO_PIN };    // Master in pin, SPI_NO_PIN for a write-only bus
+		unsigned int mode{ 0 };             // SPI mode: bit 1 is CPOL (clock idle level), bit 0 is CPHA (data sampled on the trailing edge)
+		uint32_t clock_hz{ 0 };             // Clock rate, 0 runs as fast as the register writes go
+		bool lsb_first{ false };            // Shift the least significant bit first
+	};
+
+	/**
+	 * GPSET/GPCLR masks of one bus state change
+	 */
+	struct SpiFrame {
+		uint32_t set0{ 0 }, clr0{ 0 }, set1{ 0 }, clr1{ 0 };
+
+		SpiFrame& set(unsigned int pin, bool level);
+	};
+
+	/**
+	 * Bus state changes of a configuration, computed once so shifting a bit is two table
+	 * lookups and two frame stores.
+	 * Each bit takes two phases: for CPHA 0 the data is set up with the clock idle then
+	 * the leading edge samples it, for CPHA 1 the leading edge sets up the data and the
+	 * trailing edge samples it. MISO is read after the second phase.
+	 */
+	struct SpiFrames {
+		SpiFrame bit[2][2];     // [data bit][phase]
+		SpiFrame select;        // CS asserted, clock idle
+		SpiFrame idle;          // Clock idle
+		SpiFrame deselect;      // CS released
+		bool bank0, bank1;      // Register banks holding the output pins
+		uint64_t half_period;   // Duration of a phase in nanoseconds, 0 when not paced
+
+		/**
+		 * Computes the frames of a configuration, throws on invalid pins or mode
+		 * @param config bus configuration
+		 */
+		explicit SpiFrames(const SpiConfig& config);
+	};
+
+	/**
+	 * Bit-banged SPI master, on any pins.
+	 * Transfers store frames precomputed by SpiFrames: every frame writes GPSET and GPCLR of
+	 * the banks the bus uses, zero words included, so the bit loop has no branch on the data.
+	 * Pacing and reading are compile-time variants of the loop.
+	 * Not synchronized, one thread drives the bus.
+	 * @tparam Backend register page backend of the GPIO handler
+	 */
+	template<typename Backend>
+	class SpiMaster {
+	private:
+		const BasicGPIO<Backend>& gpio;
+		const SpiConfig config;
+		const SpiFrames frames;
+
+		static uint8_t reverse(uint8_t byte)
+		{
+			byte = static_cast<uint8_t>((byte & 0xF0) >> 4 | (byte & 0x0F) << 4);
+			byte = static_cast<uint8_t>((byte & 0xCC) >> 2 | (byte & 0x33) << 2);
+			return static_cast<uint8_t>((byte & 0xAA) >> 1 | (byte & 0x55) << 1);
+		}
+
+		void apply(const SpiFrame& frame) const
+		{
+			// writing 0 to GPSETn/GPCLRn has no effect, only the bus configuration picks the stores
+			if (frames.bank0) {
+				gpio.store(GPSET0, frame.set0);
+				gpio.store(GPCLR0, frame.clr0);
+			}
+			if (frames.bank1) {
+				gpio.store(GPSET1, frame.set1);
+				gpio.store(GPCLR1, frame.clr1);
+			}
+		}
+
+		template<bool Paced>
+		void wait(uint64_t& deadline) const
+		{
+			if constexpr (Paced) {
+				deadline += frames.half_period;
+				while (monotonicNow() < deadline) {}
+			}
+		}
+
+		template<bool Paced, bool Read>
+		void shiftBytes(const uint8_t* tx, uint8_t* rx, size_t size) const
+		{
+			uint64_t deadline{ Paced ? monotonicNow() : 0 };
+			for (size_t i = 0; i < size; ++i) {
+				const uint8_t out = config.lsb_first ? reverse(tx ? tx[i] : 0) : (tx ? tx[i] : 0);
+				unsigned int in = 0;
+				for (int shift = 7; shift >= 0; --shift) {
+					const SpiFrame* phases = frames.bit[(out >> shift) & 1];
+					apply(phases[0]);
+					wait<Paced>(deadline);
+					apply(phases[1]);
+					wait<Paced>(deadline);
+					if constexpr (Read) in = in << 1 | gpio.pinLev(config.miso);
+				}
+				if constexpr (Read) rx[i] = config.lsb_first ? reverse(static_cast<uint8_t>(in)) : static_cast<uint8_t>(in);
+			}
+			apply(frames.idle);
+		}
+
+	public:
+		/**
+		 * Class constructor, configures the pins and releases the bus
+		 * @param gpio_p connected GPIO handler
+		 * @param config_p bus configuration, throws when invalid
+		 */
+		SpiMaster(const BasicGPIO<Backend>& gpio_p, const SpiConfig& config_p) : gpio{ gpio_p }, config{ config_p }, frames{ config_p }
+		{
+			apply(frames.deselect);
+			apply(frames.idle);
+			ModeConfig modes;
+			modes.set(config.cs, PIN_MODE::OUTPUT).set(config.sclk, PIN_MODE::OUTPUT).set(config.mosi, PIN_MODE::OUTPUT);
+			if (config.miso != SPI_NO_PIN) modes.set(config.miso, PIN_MODE::INPUT);
+			gpio.pinMode(modes);
+		}
+
+		SpiMaster(const SpiMaster&) = delete;
+		SpiMaster& operator=(const SpiMaster&) = delete;
+
+		/**
+		 * Asserts CS, with the clock idle
+		 */
+		void select(void) const { apply(frames.select); }
+
+		/**
+		 * Releases CS
+		 */
+		void deselect(void) const { apply(frames.deselect); }
+
+		/**
+		 * Shifts bytes out and in, CS is left as is
+		 * @param tx bytes to send, nullptr sends zeros
+		 * @param rx received bytes, nullptr to ignore MISO
+		 * @param size number of bytes
+		 */
+		void shift(const uint8_t* tx, uint8_t* rx, size_t size) const
+		{
+			const bool read = rx && config.miso != SPI_NO_PIN;
+			if (frames.half_period)
+				read ? shiftBytes<true, true>(tx, rx, size) : shiftBytes<true, false>(tx, rx, size);
+			else
+				read ? shiftBytes<false, true>(tx, rx, size) : shiftBytes<false, false>(tx, rx, size);
+		}
+
+		/**
+		 * Selects the device, shifts bytes out and in, then releases it
+		 * @param tx bytes to send, nullptr sends zeros
+		 * @param rx received bytes, nullptr to ignore MISO
+		 * @param size number of bytes
+		 */
+		void transfer(const uint8_t* tx, uint8_t* rx, size_t size) const
+		{
+			select();
+			shift(tx, rx, size);
+			deselect();
+		}
+
+		/**
+		 * Selects the device, sends bytes, then releases it
+		 * @param tx bytes to send
+		 * @param size number of bytes
+		 */
+		void write(const uint8_t* tx, size_t size) const { transfer(tx, nullptr, size); }
+
+		/**
+		 * @return bus configuration
+		 */
+		const SpiConfig& getConfig(void) const { return config; }
+	};
+}
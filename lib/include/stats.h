@@ -0,0 +1,186 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Hot-path instrumentation, enabled by compiling with RPI_GPIO_STATS defined
+ * (CMake option RPI_GPIO_ENABLE_STATS). When disabled, every counter call compiles
+ * to nothing and snapshots are empty.
+ */
+#ifdef RPI_GPIO_STATS
+#define RPI_GPIO_STAT_SCOPE(method) const ::rpigpio::stats::Scope rpigpio_stat_scope{ ::rpigpio::stats::Method::method }
+#else
+#define RPI_GPIO_STAT_SCOPE(method) ((void)0)
+#endif
+
+namespace rpigpio::stats {
+#ifdef RPI_GPIO_STATS
+	constexpr bool enabled = true;
+#else
+	constexpr bool enabled = false;
+#endif
+
+	/** Number of 32-bit registers tracked, offsets 0x00 to 0x9c **/
+	constexpr unsigned int REGISTER_COUNT = 40;
+	/** Number of pins tracked **/
+	constexpr unsigned int PIN_COUNT = 54;
+	/** Number of latency histogram buckets, bucket b counts calls of [2^b, 2^(b+1)) ns **/
+	constexpr unsigned int BUCKETS = 32;
+
+	/**
+	 * Instrumented GPIO methods
+	 */
+	enum class Method : unsigned int {
+		CONNECT,
+		DISCONNECT,
+		PIN_MODE,
+		GET_MODE,
+		PIN_UP,
+		PIN_DOWN,
+		PIN_LEV,
+		READ_ALL,
+		DIGITAL_WRITE,
+		WRITE_MASK,
+		DIGITAL_READ,
+		EDGE_DETECT,
+		READ_EVENTS,
+		CLEAR_EVENTS,
+		RESET,
+		PIN_PULL,
+		COUNT,
+	};
+	constexpr unsigned int METHOD_COUNT = static_cast<unsigned int>(Method::COUNT);
+
+	/**
+	 * @param method instrumented method
+	 * @return the method name
+	 */
+	const char* methodName(Method method);
+
+	/**
+	 * @param off register offset
+	 * @return the register name, or nullptr for reserved offsets
+	 */
+	const char* registerName(uint32_t off);
+
+	/** Live counters, updated with relaxed atomic increments **/
+	struct RegisterCounters {
+		std::atomic<uint64_t> loads{ 0 };
+		std::atomic<uint64_t> stores{ 0 };
+	};
+	struct MethodCounters {
+		std::atomic<uint64_t> calls{ 0 };
+		std::atomic<uint64_t> total_ns{ 0 };
+		std::atomic<uint64_t> histogram[BUCKETS]{};
+	};
+	extern RegisterCounters registers[REGISTER_COUNT];
+	extern MethodCounters methods[METHOD_COUNT];
+	extern std::atomic<uint64_t> pins[PIN_COUNT];
+
+	inline void countLoad([[maybe_unused]] uint32_t off)
+	{
+		if constexpr (enabled)
+			if (off / 4 < REGISTER_COUNT) registers[off / 4].loads.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	inline void countStore([[maybe_unused]] uint32_t off)
+	{
+		if constexpr (enabled)
+			if (off / 4 < REGISTER_COUNT) registers[off / 4].stores.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	inline void countPin([[maybe_unused]] unsigned int pin)
+	{
+		if constexpr (enabled)
+			if (pin < PIN_COUNT) pins[pin].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Records one call of a method
+	 * @param method instrumented method
+	 * @param ns call duration, in nanoseconds
+	 */
+	void record(Method method, uint64_t ns);
+
+	/**
+	 * Times a method call, from construction to destruction
+	 */
+	class Scope {
+	private:
+		Method method;
+		uint64_t start;
+
+	public:
+		explicit Scope(Method method_p);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	/**
+	 * Copy of all counters at one point in time
+	 */
+	struct Snapshot {
+		struct Register {
+			uint64_t loads{ 0 };
+			uint64_t stores{ 0 };
+		} registers[REGISTER_COUNT];
+
+		struct Method {
+			uint64_t calls{ 0 };
+			uint64_t total_ns{ 0 };
+			uint64_t histogram[BUCKETS]{};
+
+			/**
+			 * Estimates a latency percentile from the histogram
+			 * @param p percentile, from 0 to 100
+			 * @return upper bound of the bucket holding the percentile, in nanoseconds
+			 */
+			uint64_t percentile(double p) const;
+		} methods[METHOD_COUNT];
+
+		uint64_t pins[PIN_COUNT]{};
+
+		/**
+		 * Prints the non-zero counters
+		 */
+		friend std::ostream& operator<<(std::ostream& os, const Snapshot& snap);
+	};
+
+	/**
+	 * @return a copy of all counters
+	 */
+	Snapshot snapshot(void);
+
+	/**
+	 * Resets all counters to zero
+	 */
+	void reset(void);
+}
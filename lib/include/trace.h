@@ -0,0 +1,212 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "clock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace rpigpio {
+	/**
+	 * Register write recording, enabled by compiling with RPI_GPIO_TRACE defined
+	 * (CMake option RPI_GPIO_ENABLE_TRACE). When disabled, GPIO handlers never call
+	 * their recorder and a register write stays a single store.
+	 */
+#ifdef RPI_GPIO_TRACE
+	constexpr bool TRACE_ENABLED = true;
+#else
+	constexpr bool TRACE_ENABLED = false;
+#endif
+
+	/**
+	 * Trace file layout.
+	 * A TraceHeader followed by one TraceRecord per recorded register write, in order.
+	 * Only the output registers are recorded: GPFSEL0-5, GPSET0/1 and GPCLR0/1.
+	 */
+	constexpr uint32_t TRACE_MAGIC = 0x54475052; // "RPGT"
+	constexpr uint32_t TRACE_VERSION = 1;
+	constexpr uint32_t TRACE_LAST_REGISTER = 0x2c; // GPCLR1
+
+	struct TraceHeader {
+		uint32_t magic;             // TRACE_MAGIC
+		uint32_t version;           // TRACE_VERSION
+		uint64_t count;             // Number of records
+		uint64_t dropped;           // Writes not recorded because the buffer was full
+		uint64_t origin_time;       // Monotonic time of the start of the recording, in nanoseconds
+	};
+
+	struct TraceRecord {
+		uint64_t time;              // Time since the start of the recording, in nanoseconds
+		uint32_t off;               // Register offset
+		uint32_t value;             // Written value
+	};
+
+	/**
+	 * Records the register writes of a GPIO handler into a preallocated buffer.
+	 * Attach it with GPIO::setRecorder. Recording never allocates: once the buffer is
+	 * full, writes are counted as dropped.
+	 * record is thread-safe, each write claims its own slot, so the engines driving the
+	 * handler from their threads can record concurrently. Writes of different threads
+	 * may be recorded a few nanoseconds out of time order. start, data, size, dropped
+	 * and save must only be called while nothing records.
+	 */
+	class TraceRecorder {
+	private:
+		std::vector<TraceRecord> records;
+		std::atomic<size_t> claimed{ 0 };   // Number of claimed slots, past the capacity once writes are dropped
+		uint64_t origin{ 0 };
+
+	public:
+		/**
+		 * Class constructor
+		 * @param capacity number of writes the buffer can hold
+		 */
+		explicit TraceRecorder(size_t capacity) : records(capacity), origin{ monotonicNow() } {}
+
+		/**
+		 * Clears the buffer and restarts the clock
+		 */
+		void start(void)
+		{
+			claimed.store(0, std::memory_order_relaxed);
+			origin = monotonicNow();
+		}
+
+		/**
+		 * Records a register write, called by the GPIO handler
+		 * @param off register offset
+		 * @param value written value
+		 */
+		void record(uint32_t off, uint32_t value)
+		{
+			if (off > TRACE_LAST_REGISTER) return;
+			const size_t slot = claimed.fetch_add(1, std::memory_order_relaxed);
+			if (slot < records.size())
+				records[slot] = { monotonicNow() - origin, off, value };
+		}
+
+		/**
+		 * @return recorded writes
+		 */
+		const TraceRecord* data(void) const { return records.data(); }
+
+		/**
+		 * @return number of recorded writes
+		 */
+		size_t size(void) const { return std::min(claimed.load(std::memory_order_relaxed), records.size()); }
+
+		/**
+		 * @return number of writes not recorded because the buffer was full
+		 */
+		uint64_t dropped(void) const { return claimed.load(std::memory_order_relaxed) - size(); }
+
+		/**
+		 * Writes the trace to a file
+		 * @param path file path
+		 */
+		void save(const std::string& path) const;
+	};
+
+	/**
+	 * Reads a trace file in chunks, without loading it whole
+	 */
+	class TraceReader {
+	private:
+		FILE* file{ nullptr };
+		TraceHeader header{};
+		uint64_t remaining{ 0 };
+
+	public:
+		/**
+		 * Opens a trace file, throws when it can't be read or isn't a trace
+		 * @param path file path
+		 */
+		explicit TraceReader(const std::string& path);
+		~TraceReader();
+
+		TraceReader(const TraceReader&) = delete;
+		TraceReader& operator=(const TraceReader&) = delete;
+
+		/**
+		 * @return the file header
+		 */
+		const TraceHeader& info(void) const { return header; }
+
+		/**
+		 * Reads the next records
+		 * @param out destination array
+		 * @param max maximum number of records
+		 * @return number of records read, 0 at the end of the trace
+		 */
+		size_t read(TraceRecord* out, size_t max);
+	};
+
+	/**
+	 * Output state after a write: the levels driven by GPSET/GPCLR and the pin functions
+	 */
+	struct TraceState {
+		uint64_t time{ 0 };         // Time of the write, in nanoseconds since the start of the recording
+		uint64_t levels{ 0 };       // Output latch, bit n is pin n
+		uint32_t fsel[6]{};         // GPFSEL registers
+
+		bool sameOutput(const TraceState& o) const;
+	};
+
+	/**
+	 * Result of a trace comparison
+	 */
+	struct TraceDiff {
+		uint64_t states_a{ 0 };     // Number of output states of trace A
+		uint64_t states_b{ 0 };     // Number of output states of trace B
+		uint64_t mismatches{ 0 };   // Number of states that differ
+		uint64_t late{ 0 };         // Number of identical states further apart in time than the tolerance
+		int64_t max_skew{ 0 };      // Largest time difference between identical states, in nanoseconds
+		bool found{ false };        // Whether first_a/first_b hold the first mismatch
+		TraceState first_a;         // First differing state of trace A
+		TraceState first_b;         // First differing state of trace B
+		uint64_t first_index{ 0 };  // Index of the first differing state
+
+		bool identical(void) const { return mismatches == 0 && states_a == states_b; }
+	};
+
+	/**
+	 * Compares the pin activity of two traces.
+	 * Traces are reduced to their sequence of output states: writes that don't change the
+	 * state are ignored, and writes closer than merge_window to the previous change are
+	 * merged into it, so two sequencers issuing the same changes with a different number
+	 * of stores compare equal. Times are compared relative to the first change of each trace.
+	 * @param path_a first trace file
+	 * @param path_b second trace file
+	 * @param merge_window writes closer than this are one change, in nanoseconds
+	 * @param tolerance largest accepted time difference between identical states, in nanoseconds
+	 * @return comparison result
+	 */
+	TraceDiff diffTraces(const std::string& path_a, const std::string& path_b, uint64_t merge_window = 0, uint64_t tolerance = UINT64_MAX);
+}
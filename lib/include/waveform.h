@@ -0,0 +1,173 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+#include "gpio.h"
+#include "clock.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace rpigpio {
+	/**
+	 * One step of a compiled waveform
+	 */
+	struct WaveFrame {
+		uint64_t deadline{ 0 };     // Time of the step from the start of the waveform, in nanoseconds
+		PinSet set;                 // Pins set to HIGH
+		PinSet clr;                 // Pins set to LOW
+	};
+
+	/**
+	 * Timeline of pin transitions, compiled into an array of set/clear frames.
+	 * All transitions sharing the same time become a single frame, which is applied
+	 * with GPIO::write (at most four stores).
+	 */
+	class Waveform {
+	private:
+		struct Transition {
+			uint64_t time;
+			PinSet high;
+			PinSet low;
+		};
+
+		std::vector<Transition> transitions;
+		std::vector<WaveFrame> compiled;
+
+	public:
+		/**
+		 * Adds a single pin transition
+		 * @param time time from the start of the waveform, in nanoseconds
+		 * @param pin pin number
+		 * @param lev new level
+		 */
+		Waveform& add(uint64_t time, unsigned int pin, bool lev);
+
+		/**
+		 * Adds a multi-pin transition
+		 * @param time time from the start of the waveform, in nanoseconds
+		 * @param high pins set to HIGH
+		 * @param low pins set to LOW
+		 */
+		Waveform& add(uint64_t time, const PinSet& high, const PinSet& low);
+
+		/**
+		 * Removes all transitions
+		 */
+		void clear(void);
+
+		/**
+		 * Compiles the timeline into frames, sorted by deadline.
+		 * When a pin has several transitions at the same time, the last added one wins.
+		 * @return the compiled frames
+		 */
+		const std::vector<WaveFrame>& compile(void);
+
+		/**
+		 * @return the frames of the last compile()
+		 */
+		const std::vector<WaveFrame>& frames(void) const { return compiled; }
+	};
+
+	/**
+	 * Deviation between achieved and scheduled frame times
+	 */
+	struct PlaybackStats {
+		uint64_t frames{ 0 };   // Number of frames played
+		int64_t min{ 0 };       // Smallest deviation, in nanoseconds
+		int64_t max{ 0 };       // Largest deviation, in nanoseconds
+		double mean{ 0.0 };     // Average deviation, in nanoseconds
+		int64_t p50{ 0 };       // Median deviation, in nanoseconds
+		int64_t p99{ 0 };       // 99th percentile of the deviation, in nanoseconds
+
+		/**
+		 * Computes the statistics of a set of deviations
+		 * @param deviations deviation of each frame, reordered by the call
+		 */
+		static PlaybackStats compute(std::vector<int64_t>& deviations);
+	};
+
+	/**
+	 * Waveform playback engine.
+	 * Waits for each frame with clock_nanosleep until shortly before its deadline,
+	 * then spins on the clock for the last microseconds. The spin window is
+	 * calibrated from the measured wakeup latency of clock_nanosleep.
+	 */
+	class WaveformPlayer {
+	private:
+		uint64_t spin_window;   // Time spent spinning before each deadline, in nanoseconds
+		uint64_t lead;          // Delay between play() and the start of the waveform, in nanoseconds
+
+	public:
+		/**
+		 * Class constructor
+		 * @param spin_window_p spin window in nanoseconds, see calibrate()
+		 * @param lead_p delay between play() and the first frame, in nanoseconds
+		 */
+		explicit WaveformPlayer(uint64_t spin_window_p = 50000, uint64_t lead_p = 1000000) : spin_window{ spin_window_p }, lead{ lead_p } {}
+
+		/**
+		 * Measures the wakeup latency of clock_nanosleep and sets the spin window to
+		 * cover it
+		 * @param samples number of sleeps measured
+		 * @return the new spin window, in nanoseconds
+		 */
+		uint64_t calibrate(unsigned int samples = 100);
+
+		/**
+		 * @return the spin window, in nanoseconds
+		 */
+		uint64_t spinWindow(void) const { return spin_window; }
+
+		/**
+		 * Waits until an absolute CLOCK_MONOTONIC time
+		 * @param deadline absolute time, in nanoseconds
+		 */
+		void waitUntil(uint64_t deadline) const;
+
+		/**
+		 * Plays a compiled waveform
+		 * @param gpio connected GPIO handler
+		 * @param waveform compiled waveform
+		 * @return deviation statistics
+		 */
+		template<typename Backend>
+		PlaybackStats play(const BasicGPIO<Backend>& gpio, const Waveform& waveform) const
+		{
+			const auto& frames{ waveform.frames() };
+			std::vector<int64_t> deviations(frames.size());
+
+			const uint64_t start{ monotonicNow() + lead };
+			for (size_t i = 0; i < frames.size(); ++i) {
+				const uint64_t deadline{ start + frames[i].deadline };
+				waitUntil(deadline);
+				gpio.write(frames[i].set, frames[i].clr);
+				deviations[i] = static_cast<int64_t>(monotonicNow() - deadline);
+			}
+
+			return PlaybackStats::compute(deviations);
+		}
+	};
+}
@@ -0,0 +1,157 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "capture.h"
+
+#include <make_exception.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+using namespace rpigpio;
+
+/** CaptureWriter **/
+
+CaptureWriter::CaptureWriter(const std::string& path, uint64_t capacity)
+{
+	if (capacity == 0) capacity = 1;
+	length = sizeof(CaptureHeader) + capacity * sizeof(CaptureRecord);
+
+	if ((fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+		throw make_exception("I/O Exception ", errno);
+	if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+		const int err = errno;
+		close(fd);
+		throw make_exception("I/O Exception ", err);
+	}
+
+	void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED) {
+		const int err = errno;
+		close(fd);
+		throw make_exception("Memory Exception ", err);
+	}
+
+	header = static_cast<CaptureHeader*>(mapped);
+	records = reinterpret_cast<CaptureRecord*>(header + 1);
+	*header = CaptureHeader{ CAPTURE_MAGIC, CAPTURE_VERSION, 0, capacity, 0, 0, 0, 0, 0 };
+}
+
+CaptureWriter::~CaptureWriter()
+{
+	munmap(header, length);
+	close(fd);
+}
+
+void CaptureWriter::begin(uint64_t mask, uint64_t time, uint64_t levels)
+{
+	header->mask = mask;
+	header->count = 0;
+	header->origin_time = time;
+	header->origin_levels = levels;
+	header->samples = 0;
+	header->end_time = time;
+	last_time = time;
+	last_levels = levels;
+}
+
+void CaptureWriter::push(uint32_t delta, uint32_t run, uint64_t levels)
+{
+	const uint64_t count = header->count;
+	auto& record = records[count % header->capacity];
+
+	// overwriting the oldest record moves the origin forward
+	if (count >= header->capacity) {
+		header->origin_time += record.delta;
+		header->origin_levels = record.levels;
+	}
+
+	record = CaptureRecord{ delta, run, levels };
+	std::atomic_thread_fence(std::memory_order_release);
+	header->count = count + 1;
+}
+
+void CaptureWriter::append(uint64_t time, uint32_t run, uint64_t levels)
+{
+	constexpr uint64_t MAX_DELTA = std::numeric_limits<uint32_t>::max();
+
+	// deltas that don't fit are split with records repeating the previous levels
+	uint64_t delta = time - last_time;
+	while (delta > MAX_DELTA) {
+		push(static_cast<uint32_t>(MAX_DELTA), 0, last_levels);
+		delta -= MAX_DELTA;
+	}
+	push(static_cast<uint32_t>(delta), run, levels);
+
+	last_time = time;
+	last_levels = levels;
+}
+
+void CaptureWriter::end(uint64_t time, uint64_t samples)
+{
+	header->samples = samples;
+	header->end_time = time;
+	msync(header, length, MS_ASYNC);
+}
+
+/** CaptureReader **/
+
+CaptureReader::CaptureReader(const std::string& path)
+{
+	if ((fd = open(path.c_str(), O_RDONLY)) < 0)
+		throw make_exception("I/O Exception ", errno);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CaptureHeader)) {
+		close(fd);
+		throw make_exception("Invalid capture file: ", path);
+	}
+	length = static_cast<size_t>(st.st_size);
+
+	void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED) {
+		const int err = errno;
+		close(fd);
+		throw make_exception("Memory Exception ", err);
+	}
+
+	header = static_cast<const CaptureHeader*>(mapped);
+	records = reinterpret_cast<const CaptureRecord*>(header + 1);
+	if (header->magic != CAPTURE_MAGIC || header->version != CAPTURE_VERSION || header->capacity == 0
+		|| length < sizeof(CaptureHeader) + header->capacity * sizeof(CaptureRecord)) {
+		munmap(mapped, length);
+		close(fd);
+		throw make_exception("Invalid capture file: ", path);
+	}
+}
+
+CaptureReader::~CaptureReader()
+{
+	munmap(const_cast<CaptureHeader*>(header), length);
+	close(fd);
+}
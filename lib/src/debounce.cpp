@@ -0,0 +1,78 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "debounce.h"
+
+#include <make_exception.hpp>
+
+using namespace rpigpio;
+
+Debouncer::Debouncer(unsigned int threshold_p, const PinSet& pins, const PinLevels& initial)
+	: mask{ pins.mask() }, stable{ 0 }, threshold{ threshold_p }
+{
+	if (threshold == 0 || threshold > MAX_THRESHOLD)
+		throw make_exception("Invalid debounce threshold: ", threshold);
+	reset(initial);
+}
+
+PinSet Debouncer::update(const PinLevels& sample)
+{
+	const uint64_t delta = (sample.value ^ stable) & mask;
+
+	// increment the counters of differing pins, restart the others
+	uint64_t carry = delta;
+	for (unsigned int b = 0; b < PLANES; ++b) {
+		const uint64_t next = count[b] & carry;
+		count[b] = (count[b] ^ carry) & delta;
+		carry = next;
+	}
+
+	// counters equal to the threshold
+	uint64_t reached = delta;
+	for (unsigned int b = 0; b < PLANES; ++b)
+		reached &= ~(count[b] ^ target[b]);
+
+	stable ^= reached;
+	for (unsigned int b = 0; b < PLANES; ++b)
+		count[b] &= ~reached;
+	return PinSet::fromMask(reached);
+}
+
+void Debouncer::reset(const PinLevels& initial)
+{
+	stable = initial.value & mask;
+	for (unsigned int b = 0; b < PLANES; ++b) {
+		count[b] = 0;
+		target[b] = (threshold >> b) & 1 ? ~0ull : 0;
+	}
+}
+
+PinSet Debouncer::pending(void) const
+{
+	uint64_t any = 0;
+	for (const auto& plane : count)
+		any |= plane;
+	return PinSet::fromMask(any);
+}
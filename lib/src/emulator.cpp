@@ -0,0 +1,211 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "emulator.h"
+
+#include <algorithm>
+
+using namespace rpigpio;
+
+namespace {
+	constexpr uint64_t PIN_MASK = (1ull << PIN_COUNT) - 1;
+}
+
+/** Private methods **/
+
+void Bcm2835Emulator::tick()
+{
+	++cycle;
+	bool changed = false;
+	while (next_step < steps.size() && steps[next_step].at <= cycle) {
+		const StimulusStep& step = steps[next_step++];
+		const uint64_t pins = step.pins.mask();
+		driven |= pins;
+		input = (input & ~pins) | (step.levels.mask() & pins);
+		changed = true;
+	}
+	if (changed) update();
+}
+
+void Bcm2835Emulator::update()
+{
+	// lowest to highest precedence: last level, pulls, loopbacks, external drive, output latch
+	uint64_t next = (level | pull_up) & ~pull_down;
+	const uint64_t sources = (latch & outputs) | (next & ~outputs);
+	for (const auto& [from, to] : loops)
+		next = (next & ~(1ull << to)) | (((sources >> from) & 1u) << to);
+	next = (next & ~driven) | (input & driven);
+	next = ((next & ~outputs) | (latch & outputs)) & PIN_MASK;
+
+	const uint64_t rising = next & ~level;
+	const uint64_t falling = level & ~next;
+	level = next;
+	events |= (rising & (pair(GPREN0) | pair(GPAREN0))) | (falling & (pair(GPFEN0) | pair(GPAFEN0)));
+	detectLevels();
+}
+
+void Bcm2835Emulator::detectLevels()
+{
+	events |= ((level & pair(GPHEN0)) | (~level & pair(GPLEN0))) & PIN_MASK;
+}
+
+/** Public methods **/
+
+uint32_t Bcm2835Emulator::load(uint32_t off)
+{
+	std::lock_guard<Spinlock> lock(busy);
+	tick();
+	switch (off) {
+	case GPSET0: case GPSET1: case GPCLR0: case GPCLR1:
+		return 0;
+	case GPLEV0: return static_cast<uint32_t>(level);
+	case GPLEV1: return static_cast<uint32_t>(level >> 32);
+	case GPEDS0: return static_cast<uint32_t>(events);
+	case GPEDS1: return static_cast<uint32_t>(events >> 32);
+	default:
+		return off < PAGE_SIZE ? regs[off / 4] : 0;
+	}
+}
+
+void Bcm2835Emulator::store(uint32_t off, uint32_t value)
+{
+	std::lock_guard<Spinlock> lock(busy);
+	tick();
+	switch (off) {
+	case GPSET0: case GPSET1:
+		latch = (latch | static_cast<uint64_t>(value) << (off == GPSET1 ? 32 : 0)) & PIN_MASK;
+		update();
+		return;
+	case GPCLR0: case GPCLR1:
+		latch &= ~(static_cast<uint64_t>(value) << (off == GPCLR1 ? 32 : 0));
+		update();
+		return;
+	case GPLEV0: case GPLEV1:
+		return;
+	case GPEDS0: case GPEDS1:
+		events &= ~(static_cast<uint64_t>(value) << (off == GPEDS1 ? 32 : 0));
+		detectLevels();
+		return;
+	case GPPUDCLK0: case GPPUDCLK1: {
+		regs[off / 4] = value;
+		const uint64_t clocked = (static_cast<uint64_t>(value) << (off == GPPUDCLK1 ? 32 : 0)) & PIN_MASK;
+		switch (regs[GPPUD / 4] & 0b11u) {
+		case 0: pull_up &= ~clocked; pull_down &= ~clocked; break;
+		case 1: pull_up &= ~clocked; pull_down |= clocked; break;
+		case 2: pull_up |= clocked; pull_down &= ~clocked; break;
+		default: break;     // reserved control value
+		}
+		update();
+		return;
+	}
+	default:
+		break;
+	}
+
+	if (off >= PAGE_SIZE) return;
+	regs[off / 4] = value;
+	if (off <= GPFSEL[5]) {
+		const unsigned int rnum = off / 4;
+		for (unsigned int i = 0; i < 10 && rnum * 10 + i < PIN_COUNT; ++i) {
+			const uint64_t bit = 1ull << (rnum * 10 + i);
+			if (((value >> (i * 3)) & 0b111u) == 1u) outputs |= bit;
+			else outputs &= ~bit;
+		}
+		update();
+	}
+	else if (off >= GPREN0 && off <= GPAFEN1) {
+		detectLevels();
+	}
+}
+
+void Bcm2835Emulator::drive(const PinSet& pins, const PinSet& levels)
+{
+	std::lock_guard<Spinlock> lock(busy);
+	driven |= pins.mask();
+	input = (input & ~pins.mask()) | (levels.mask() & pins.mask());
+	update();
+}
+
+void Bcm2835Emulator::release(const PinSet& pins)
+{
+	std::lock_guard<Spinlock> lock(busy);
+	driven &= ~pins.mask();
+	update();
+}
+
+void Bcm2835Emulator::loopback(unsigned int from, unsigned int to)
+{
+	if (from >= PIN_COUNT || to >= PIN_COUNT || from == to) return;
+	std::lock_guard<Spinlock> lock(busy);
+	loops.erase(std::remove_if(loops.begin(), loops.end(), [to](const auto& loop) { return loop.second == to; }), loops.end());
+	loops.emplace_back(from, to);
+	update();
+}
+
+void Bcm2835Emulator::unloop(unsigned int to)
+{
+	std::lock_guard<Spinlock> lock(busy);
+	loops.erase(std::remove_if(loops.begin(), loops.end(), [to](const auto& loop) { return loop.second == to; }), loops.end());
+}
+
+void Bcm2835Emulator::script(std::vector<StimulusStep> script)
+{
+	std::stable_sort(script.begin(), script.end(), [](const StimulusStep& a, const StimulusStep& b) { return a.at < b.at; });
+	std::lock_guard<Spinlock> lock(busy);
+	for (auto& step : script)
+		step.at += cycle;
+	steps = std::move(script);
+	next_step = 0;
+}
+
+PinLevels Bcm2835Emulator::levels() const
+{
+	std::lock_guard<Spinlock> lock(busy);
+	return PinLevels{ level };
+}
+
+PinSet Bcm2835Emulator::pullUps() const
+{
+	std::lock_guard<Spinlock> lock(busy);
+	return PinSet::fromMask(pull_up);
+}
+
+PinSet Bcm2835Emulator::pullDowns() const
+{
+	std::lock_guard<Spinlock> lock(busy);
+	return PinSet::fromMask(pull_down);
+}
+
+uint64_t Bcm2835Emulator::cycles() const
+{
+	std::lock_guard<Spinlock> lock(busy);
+	return cycle;
+}
+
+int EmuMem::open() const
+{
+	// the mapped page is only a placeholder, all accesses go through the emulator
+	return AnonMem{}.open();
+}
@@ -24,20 +24,53 @@ SOFTWARE.
 
 */
 #include "gpio.h"
+#include "emulator.h"
+#include "clock.h"
+
+#include <algorithm>
+#include <iterator>
 
 using namespace rpigpio;
 
 /** Public methods **/
 
-bool GPIO::connect()
+template<typename Backend>
+BasicGPIO<Backend>::BasicGPIO(BasicGPIO&& o) noexcept :
+	peripheral{ std::move(o.peripheral) },
+	p_base{ std::exchange(o.p_base, nullptr) },
+	fsel_shadowed{ o.fsel_shadowed },
+	recorder{ o.recorder }
+{
+	std::copy(std::begin(o.fsel_shadow), std::end(o.fsel_shadow), fsel_shadow);
+}
+
+template<typename Backend>
+BasicGPIO<Backend>& BasicGPIO<Backend>::operator=(BasicGPIO&& o) noexcept
+{
+	if (this != &o) {
+		peripheral = std::move(o.peripheral);
+		p_base = std::exchange(o.p_base, nullptr);
+		fsel_shadowed = o.fsel_shadowed;
+		recorder = o.recorder;
+		std::copy(std::begin(o.fsel_shadow), std::end(o.fsel_shadow), fsel_shadow);
+	}
+	return *this;
+}
+
+template<typename Backend>
+bool BasicGPIO<Backend>::connect()
 {
+	RPI_GPIO_STAT_SCOPE(CONNECT);
 	if (!peripheral.map()) return false;
 	p_base = peripheral.getBase();
+	if (fsel_shadowed) syncModeShadow();
 	return true;
 }
 
-bool GPIO::disconnect()
+template<typename Backend>
+bool BasicGPIO<Backend>::disconnect()
 {
+	RPI_GPIO_STAT_SCOPE(DISCONNECT);
 	if (p_base) {
 		peripheral.unmap();
 		p_base = nullptr;
@@ -46,80 +79,237 @@ bool GPIO::disconnect()
 	return true;
 }
 
-void GPIO::pinMode(unsigned int pin, PIN_MODE mode) const
+template<typename Backend>
+void BasicGPIO<Backend>::pinMode(unsigned int pin, PIN_MODE mode) const
+{
+	pinMode(ModeConfig{}.set(pin, mode));
+}
+
+template<typename Backend>
+void BasicGPIO<Backend>::pinMode(const ModeConfig& config) const
 {
+	RPI_GPIO_STAT_SCOPE(PIN_MODE);
+	for (unsigned int rnum = 0; rnum < 6; ++rnum) {
+		if (!config.mask[rnum]) continue;
+
+		const uint32_t current = fsel_shadowed ? fsel_shadow[rnum] : load(GPFSEL[rnum]);
+		const uint32_t next = (current & ~config.mask[rnum]) | config.value[rnum];
+		if (fsel_shadowed) {
+			if (next == current) continue;
+			fsel_shadow[rnum] = next;
+		}
+		store(GPFSEL[rnum], next);
+	}
+}
+
+template<typename Backend>
+PIN_MODE BasicGPIO<Backend>::getMode(unsigned int pin) const
+{
+	RPI_GPIO_STAT_SCOPE(GET_MODE);
+	stats::countPin(pin);
+	if (pin >= PIN_COUNT) return PIN_MODE::INPUT;
 	unsigned int rnum = pin / 10;
 	unsigned int offset = (pin % 10) * 3;
-	r(GPFSEL[rnum]) = r(GPFSEL[rnum]) & ~(0b111 << offset);
-	r(GPFSEL[rnum]) = r(GPFSEL[rnum]) | (mode << offset);
+	const uint32_t fsel = fsel_shadowed ? fsel_shadow[rnum] : load(GPFSEL[rnum]);
+	return PIN_MODE{ (fsel >> offset) & 0b111u };
 }
 
-void GPIO::pinUp(unsigned int pin) const
+template<typename Backend>
+void BasicGPIO<Backend>::setModeShadow(bool enable)
 {
+	fsel_shadowed = enable;
+	if (fsel_shadowed && p_base) syncModeShadow();
+}
+
+template<typename Backend>
+void BasicGPIO<Backend>::syncModeShadow() const
+{
+	for (unsigned int rnum = 0; rnum < 6; ++rnum)
+		fsel_shadow[rnum] = load(GPFSEL[rnum]);
+}
+
+template<typename Backend>
+void BasicGPIO<Backend>::pinUp(unsigned int pin) const
+{
+	RPI_GPIO_STAT_SCOPE(PIN_UP);
+	stats::countPin(pin);
 	if (pin < 32) {
-		auto& p = r(GPSET0);
-		p = p | 1 << pin;
+		store(GPSET0, 1u << pin);
 	}
 	else if (pin >= 32) {
-		auto& p = r(GPSET1);
-		p = p | 1 << (pin - 32);
+		store(GPSET1, 1u << (pin - 32));
 	}
 }
 
-void GPIO::pinDown(unsigned int pin) const
+template<typename Backend>
+void BasicGPIO<Backend>::pinDown(unsigned int pin) const
 {
+	RPI_GPIO_STAT_SCOPE(PIN_DOWN);
+	stats::countPin(pin);
 	if (pin < 32) {
-		auto& p = r(GPCLR0);
-		p = p | 1 << pin;
+		store(GPCLR0, 1u << pin);
 	}
 	else if (pin >= 32) {
-		auto& p = r(GPCLR1);
-		p = p | 1 << (pin - 32);
+		store(GPCLR1, 1u << (pin - 32));
 	}
 }
 
-unsigned int GPIO::pinLev(unsigned int pin) const
+template<typename Backend>
+unsigned int BasicGPIO<Backend>::pinLev(unsigned int pin) const
 {
+	RPI_GPIO_STAT_SCOPE(PIN_LEV);
+	stats::countPin(pin);
 	if (pin < 32) {
-		return (r(GPLEV0) & 1 << pin) != 0;
+		return (load(GPLEV0) & 1u << pin) != 0;
 	}
 	else if (pin >= 32) {
-		return (r(GPLEV1) & 1 << (pin - 32)) != 0;
+		return (load(GPLEV1) & 1u << (pin - 32)) != 0;
 	}
 	else {
 		return 0;
 	}
 }
 
-void GPIO::digitalWrite(unsigned int pin, bool lev) const
+template<typename Backend>
+PinLevels BasicGPIO<Backend>::readAll() const
+{
+	RPI_GPIO_STAT_SCOPE(READ_ALL);
+	const uint32_t lev0 = load(GPLEV0);
+	return { lev0, load(GPLEV1) };
+}
+
+template<typename Backend>
+void BasicGPIO<Backend>::digitalWrite(unsigned int pin, bool lev) const
 {
+	RPI_GPIO_STAT_SCOPE(DIGITAL_WRITE);
 	if (lev)
 		pinUp(pin);
 	else
 		pinDown(pin);
 }
 
-unsigned int GPIO::digitalRead(unsigned int pin) const
+template<typename Backend>
+void BasicGPIO<Backend>::writeMask(uint32_t set0, uint32_t clr0, uint32_t set1, uint32_t clr1) const
+{
+	RPI_GPIO_STAT_SCOPE(WRITE_MASK);
+	// GPSETn/GPCLRn are write-only, zero bits have no effect
+	if (set0) store(GPSET0, set0);
+	if (clr0) store(GPCLR0, clr0);
+	if (set1) store(GPSET1, set1);
+	if (clr1) store(GPCLR1, clr1);
+}
+
+template<typename Backend>
+void BasicGPIO<Backend>::write(const PinSet& high, const PinSet& low) const
+{
+	writeMask(high.bank0, low.bank0, high.bank1, low.bank1);
+}
+
+template<typename Backend>
+void BasicGPIO<Backend>::writeFrame(const PinSet& pins, const PinSet& levels) const
+{
+	write(pins & levels, pins & ~levels);
+}
+
+template<typename Backend>
+unsigned int BasicGPIO<Backend>::digitalRead(unsigned int pin) const
 {
+	RPI_GPIO_STAT_SCOPE(DIGITAL_READ);
 	return pinLev(pin);
 }
 
-void GPIO::reset() const
+template<typename Backend>
+void BasicGPIO<Backend>::edgeDetect(const PinSet& pins, EDGE_DETECT type, bool enable) const
 {
-	auto& p1 = r(GPFSEL[0]);
-	p1 = p1 & ~(0xFFFFFFC0);
-	r(GPFSEL[1]) = 0;
-	auto& p2 = r(GPFSEL[2]);
-	p2 = p2 & ~(0xFFFFFF);
-	r(GPCLR0) = 0xFFFFFFC;
+	RPI_GPIO_STAT_SCOPE(EDGE_DETECT);
+	if (pins.bank0) {
+		const uint32_t p = load(type.reg0);
+		store(type.reg0, enable ? (p | pins.bank0) : (p & ~pins.bank0));
+	}
+	if (pins.bank1) {
+		const uint32_t p = load(type.reg1);
+		store(type.reg1, enable ? (p | pins.bank1) : (p & ~pins.bank1));
+	}
 }
 
+template<typename Backend>
+PinSet BasicGPIO<Backend>::edgeDetectEnabled(EDGE_DETECT type) const
+{
+	const uint32_t en0 = load(type.reg0);
+	return PinSet::fromBanks(en0, load(type.reg1));
+}
 
+template<typename Backend>
+PinSet BasicGPIO<Backend>::readEvents() const
+{
+	RPI_GPIO_STAT_SCOPE(READ_EVENTS);
+	const uint32_t eds0 = load(GPEDS0);
+	return PinSet::fromBanks(eds0, load(GPEDS1));
+}
 
+template<typename Backend>
+void BasicGPIO<Backend>::clearEvents(const PinSet& pins) const
+{
+	RPI_GPIO_STAT_SCOPE(CLEAR_EVENTS);
+	if (pins.bank0) store(GPEDS0, pins.bank0);
+	if (pins.bank1) store(GPEDS1, pins.bank1);
+}
 
-/** Private methods **/
+template<typename Backend>
+PinSet BasicGPIO<Backend>::takeEvents(const PinSet& pins) const
+{
+	const PinSet events{ readEvents() & pins };
+	clearEvents(events);
+	return events;
+}
 
-volatile uint32_t& GPIO::r(const uint32_t off) const
+template<typename Backend>
+void BasicGPIO<Backend>::pinPull(unsigned int pin, PULL_MODE pull) const
 {
-	return *(p_base + (off / 4));
+	pinPull(PullConfig{}.set(pin, pull));
 }
+
+template<typename Backend>
+void BasicGPIO<Backend>::pinPull(const PullConfig& config) const
+{
+	RPI_GPIO_STAT_SCOPE(PIN_PULL);
+	const auto& settle = []() {
+		const uint64_t end = monotonicNow() + PULL_SETTLE_NS;
+		while (monotonicNow() < end) {}
+	};
+
+	bool applied = false;
+	for (unsigned int pull = 0; pull < 3; ++pull) {
+		const PinSet& pins = config.pins[pull];
+		if (pins.empty()) continue;
+
+		store(GPPUD, pull);
+		settle();
+		if (pins.bank0) store(GPPUDCLK0, pins.bank0);
+		if (pins.bank1) store(GPPUDCLK1, pins.bank1);
+		settle();
+		// remove the clocks before the control changes for the next group
+		if (pins.bank0) store(GPPUDCLK0, 0);
+		if (pins.bank1) store(GPPUDCLK1, 0);
+		applied = true;
+	}
+	if (applied) store(GPPUD, PULL_MODE::OFF);
+}
+
+template<typename Backend>
+void BasicGPIO<Backend>::reset() const
+{
+	RPI_GPIO_STAT_SCOPE(RESET);
+	// pins 2 to 27 back to INPUT
+	ModeConfig config;
+	for (unsigned int pin = 2; pin <= 27; ++pin)
+		config.set(pin, PIN_MODE::INPUT);
+	pinMode(config);
+	store(GPCLR0, 0xFFFFFFC);
+}
+
+template class rpigpio::BasicGPIO<DevMem>;
+template class rpigpio::BasicGPIO<GpioMem>;
+template class rpigpio::BasicGPIO<AnonMem>;
+template class rpigpio::BasicGPIO<FileMem>;
+template class rpigpio::BasicGPIO<EmuMem>;
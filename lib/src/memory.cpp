@@ -24,6 +24,7 @@ SOFTWARE.
 
 */
 #include "memory.h"
+#include "emulator.h"
 
 #include <make_exception.hpp>
 
@@ -34,51 +35,166 @@ SOFTWARE.
 #include <cstdint>
 #include <unistd.h>
 #include <cstdio>
+#include <mutex>
+#include <unordered_map>
 
 using namespace rpigpio;
 
+/* Backends */
+
+int DevMem::open() const
+{
+	return ::open("/dev/mem", O_RDWR | O_SYNC);
+}
+
+int GpioMem::open() const
+{
+	return ::open("/dev/gpiomem", O_RDWR | O_SYNC);
+}
+
+int AnonMem::open() const
+{
+	int fd = memfd_create("rpigpio", MFD_CLOEXEC);
+	if (fd >= 0 && ftruncate(fd, PAGE_SIZE) != 0) {
+		::close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int FileMem::open() const
+{
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0) return -1;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (st.st_size < static_cast<off_t>(PAGE_SIZE) && ftruncate(fd, PAGE_SIZE) != 0)) {
+		::close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Mapping registry */
+
+namespace {
+	/**
+	 * A process-wide mapping of a shared backend
+	 */
+	struct SharedMapping {
+		int fd;                 // Backend file descriptor
+		void* mapped;           // Mapped page
+		size_t refs;            // Number of Bcm2835Periph using the mapping
+	};
+
+	/**
+	 * Shared mappings of a backend, keyed by physical base address
+	 */
+	struct MappingRegistry {
+		std::mutex mutex;
+		std::unordered_map<uint32_t, SharedMapping> mappings;
+	};
+
+	/**
+	 * Never destroyed: static handlers that unmap during exit may be destroyed after it
+	 */
+	template<typename Backend>
+	MappingRegistry& registry()
+	{
+		static MappingRegistry* reg = new MappingRegistry;
+		return *reg;
+	}
+}
+
 /* Public methods */
-Bcm2835Periph::Bcm2835Periph(uint32_t addr_p) : addr{ addr_p } {}
+template<typename Backend>
+Bcm2835Periph<Backend>::Bcm2835Periph(uint32_t addr_p, Backend backend_p) : backend{ std::move(backend_p) }, addr{ addr_p } {}
 
-Bcm2835Periph::~Bcm2835Periph()
+template<typename Backend>
+Bcm2835Periph<Backend>::~Bcm2835Periph()
 {
 	if (mapped) {
 		unmap();
 	}
 
-	if (mem_fd) {
+	if (mem_fd >= 0) {
 		closeMem();
 	}
 }
 
-bool Bcm2835Periph::map()
+template<typename Backend>
+Bcm2835Periph<Backend>::Bcm2835Periph(Bcm2835Periph&& o) noexcept :
+	backend{ std::move(o.backend) },
+	addr{ o.addr },
+	mem_fd{ std::exchange(o.mem_fd, -1) },
+	mapped{ std::exchange(o.mapped, nullptr) },
+	base{ std::exchange(o.base, nullptr) }
+{}
+
+template<typename Backend>
+Bcm2835Periph<Backend>& Bcm2835Periph<Backend>::operator=(Bcm2835Periph&& o) noexcept
 {
-	if (!openMem()) throw make_exception("I/O Exception ", errno);
-
-	mapped = mmap(
-		nullptr,
-		PAGE_SIZE,
-		PROT_READ | PROT_WRITE,
-		MAP_SHARED,
-		mem_fd,
-		addr
-	);
+	if (this != &o) {
+		if (mapped) unmap();
+		if (mem_fd >= 0) closeMem();
+		backend = std::move(o.backend);
+		addr = o.addr;
+		mem_fd = std::exchange(o.mem_fd, -1);
+		mapped = std::exchange(o.mapped, nullptr);
+		base = std::exchange(o.base, nullptr);
+	}
+	return *this;
+}
 
-	if (!mapped) throw make_exception("Memory Exception ", errno);
-	else base = reinterpret_cast<volatile uint32_t*> (mapped);
+template<typename Backend>
+bool Bcm2835Periph<Backend>::map()
+{
+	if (mapped) return true;
+
+	if constexpr (Backend::shared) {
+		auto& reg = registry<Backend>();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		if (const auto it = reg.mappings.find(addr); it != reg.mappings.end()) {
+			++it->second.refs;
+			mapped = it->second.mapped;
+			base = reinterpret_cast<volatile uint32_t*>(mapped);
+			return true;
+		}
+
+		mapPage();
+		// the registry owns the file descriptor of shared mappings
+		reg.mappings.emplace(addr, SharedMapping{ std::exchange(mem_fd, -1), mapped, 1 });
+	}
+	else mapPage();
 
 	return true;
 }
 
-void Bcm2835Periph::unmap()
+template<typename Backend>
+void Bcm2835Periph<Backend>::unmap()
 {
-	munmap(mapped, PAGE_SIZE);
+	if (!mapped) return;
+
+	if constexpr (Backend::shared) {
+		auto& reg = registry<Backend>();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		if (const auto it = reg.mappings.find(addr); it != reg.mappings.end() && --it->second.refs == 0) {
+			munmap(it->second.mapped, PAGE_SIZE);
+			close(it->second.fd);
+			reg.mappings.erase(it);
+		}
+	}
+	else {
+		munmap(mapped, PAGE_SIZE);
+		closeMem();
+	}
+
 	mapped = nullptr;
 	base = nullptr;
-	closeMem();
 }
 
-volatile uint32_t* Bcm2835Periph::getBase() const
+template<typename Backend>
+volatile uint32_t* Bcm2835Periph<Backend>::getBase() const
 {
 	if (base) return base;
 	else return nullptr;
@@ -90,13 +206,44 @@ volatile uint32_t* Bcm2835Periph::getBase() const
 
 /* Private methods */
 
-bool Bcm2835Periph::openMem()
+template<typename Backend>
+void Bcm2835Periph<Backend>::mapPage()
 {
-	return ((mem_fd = open("/dev/mem", O_RDWR | O_SYNC)) >= 0);
+	if (!openMem()) throw make_exception("I/O Exception ", errno);
+
+	mapped = mmap(
+		nullptr,
+		PAGE_SIZE,
+		PROT_READ | PROT_WRITE,
+		MAP_SHARED,
+		mem_fd,
+		backend.offset(addr)
+	);
+
+	if (mapped == MAP_FAILED) {
+		const int err = errno;
+		mapped = nullptr;
+		closeMem();
+		throw make_exception("Memory Exception ", err);
+	}
+	else base = reinterpret_cast<volatile uint32_t*> (mapped);
+}
+
+template<typename Backend>
+bool Bcm2835Periph<Backend>::openMem()
+{
+	return ((mem_fd = backend.open()) >= 0);
 }
 
-void Bcm2835Periph::closeMem()
+template<typename Backend>
+void Bcm2835Periph<Backend>::closeMem()
 {
 	close(mem_fd);
-	mem_fd = 0;
-}
\ No newline at end of file
+	mem_fd = -1;
+}
+
+template class rpigpio::Bcm2835Periph<DevMem>;
+template class rpigpio::Bcm2835Periph<GpioMem>;
+template class rpigpio::Bcm2835Periph<AnonMem>;
+template class rpigpio::Bcm2835Periph<FileMem>;
+template class rpigpio::Bcm2835Periph<EmuMem>;
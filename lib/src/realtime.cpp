@@ -0,0 +1,106 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "realtime.h"
+
+#include <sys/mman.h>
+#include <alloca.h>
+
+#include <fstream>
+#include <mutex>
+#include <string>
+
+using namespace rpigpio;
+
+namespace {
+	/**
+	 * mlockall and munlockall apply to the whole process: the memory stays locked
+	 * while any context holds the lock
+	 */
+	std::mutex lock_mutex;
+	unsigned int lock_holders{ 0 };
+}
+
+RealtimeContext::RealtimeContext(const RealtimeConfig& config)
+{
+	const pthread_t self{ pthread_self() };
+
+	CPU_ZERO(&previous_affinity);
+	cpu_index = config.cpu >= 0 ? config.cpu : isolatedCpu();
+	if (cpu_index >= 0 && cpu_index < CPU_SETSIZE && pthread_getaffinity_np(self, sizeof(previous_affinity), &previous_affinity) == 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu_index, &set);
+		is_pinned = pthread_setaffinity_np(self, sizeof(set), &set) == 0;
+	}
+
+	if (config.priority > 0 && pthread_getschedparam(self, &previous_policy, &previous_param) == 0) {
+		sched_param param{};
+		param.sched_priority = config.priority;
+		is_scheduled = pthread_setschedparam(self, SCHED_FIFO, &param) == 0;
+	}
+
+	if (config.lock_memory) {
+		std::lock_guard<std::mutex> lock(lock_mutex);
+		is_locked = lock_holders > 0 || mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+		if (is_locked) ++lock_holders;
+	}
+
+	// with MCL_FUTURE the touched stack pages stay resident
+	if (config.stack_prefault)
+		prefaultStack(config.stack_prefault);
+}
+
+RealtimeContext::~RealtimeContext()
+{
+	const pthread_t self{ pthread_self() };
+	if (is_locked) {
+		std::lock_guard<std::mutex> lock(lock_mutex);
+		if (--lock_holders == 0) munlockall();
+	}
+	if (is_scheduled) pthread_setschedparam(self, previous_policy, &previous_param);
+	if (is_pinned) pthread_setaffinity_np(self, sizeof(previous_affinity), &previous_affinity);
+}
+
+int RealtimeContext::isolatedCpu()
+{
+	// list format, e.g. "2-3,5", empty when no CPU is isolated
+	std::ifstream file{ "/sys/devices/system/cpu/isolated" };
+	std::string list;
+	if (!std::getline(file, list) || list.empty()) return -1;
+	try {
+		return std::stoi(list);
+	} catch (...) {
+		return -1;
+	}
+}
+
+void RealtimeContext::prefaultStack(size_t bytes)
+{
+	// one write per page faults the region in, volatile keeps the writes
+	volatile unsigned char* stack{ static_cast<volatile unsigned char*>(alloca(bytes)) };
+	for (size_t i = 0; i < bytes; i += PAGE_SIZE)
+		stack[i] = 0;
+}
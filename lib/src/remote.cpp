@@ -0,0 +1,232 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "remote.h"
+
+#include <make_exception.hpp>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+using namespace rpigpio;
+
+static sockaddr_un socketAddress(const std::string& path)
+{
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path))
+		throw make_exception("Socket path too long: '", path, "'");
+	std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+	return addr;
+}
+
+/** RemoteServer **/
+
+RemoteServer::RemoteServer(const std::string& path_p, mode_t mode) : path{ path_p }
+{
+	const sockaddr_un addr = socketAddress(path);
+
+	if ((listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0)
+		throw make_exception("Socket Exception ", errno);
+
+	// only replace a stale socket: never another kind of file, never a socket still served
+	struct stat st;
+	if (lstat(path.c_str(), &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			close(listen_fd);
+			throw make_exception("Not a socket, refusing to replace: '", path, "'");
+		}
+		const int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+		const bool served = probe >= 0 && connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+		if (probe >= 0) close(probe);
+		if (served) {
+			close(listen_fd);
+			throw make_exception("Socket already in use by a running server: '", path, "'");
+		}
+		unlink(path.c_str());
+	}
+
+	// the socket file is created with its final permissions, the umask is process-wide and
+	// briefly changed for the bind
+	const mode_t previous_umask = umask(~mode & 0777);
+	const bool bound = bind(listen_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+	const int bind_err = errno;
+	umask(previous_umask);
+	if (!bound) {
+		close(listen_fd);
+		throw make_exception("Socket Exception ", bind_err);
+	}
+	if (listen(listen_fd, SOMAXCONN) != 0) {
+		const int err = errno;
+		close(listen_fd);
+		unlink(path.c_str());
+		throw make_exception("Socket Exception ", err);
+	}
+
+	epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.fd = listen_fd;
+	if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) != 0) {
+		const int err = errno;
+		if (epoll_fd >= 0) close(epoll_fd);
+		close(listen_fd);
+		unlink(path.c_str());
+		throw make_exception("Epoll Exception ", err);
+	}
+}
+
+RemoteServer::~RemoteServer()
+{
+	close(epoll_fd);
+	close(listen_fd);
+	unlink(path.c_str());
+}
+
+int RemoteServer::wait(int* ready, int max, int timeout)
+{
+	epoll_event events[64];
+	const int n = epoll_wait(epoll_fd, events, max < 64 ? max : 64, timeout);
+	int count = 0;
+	for (int i = 0; i < n; ++i) {
+		const int fd = events[i].data.fd;
+		if (fd != listen_fd) {
+			ready[count++] = fd;
+			continue;
+		}
+
+		for (int client; (client = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0;) {
+			epoll_event ev{};
+			ev.events = EPOLLIN;
+			ev.data.fd = client;
+			if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client, &ev) != 0)
+				close(client);
+			else
+				++stats.connections;
+		}
+	}
+	return count;
+}
+
+ssize_t RemoteServer::receive(int fd, RemoteRequest& req)
+{
+	const ssize_t len = recv(fd, &req, sizeof(req), 0);
+	if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+	// a hang up reads 0 bytes, report it as a bad message
+	return len == 0 ? -1 : len;
+}
+
+bool RemoteServer::reply(int fd, const RemoteResponse& resp)
+{
+	// responses are small, the socket buffer only fills up when a client stops reading
+	return send(fd, &resp, sizeof(resp), MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(resp));
+}
+
+void RemoteServer::drop(int fd)
+{
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+	close(fd);
+}
+
+/** RemoteClient **/
+
+RemoteClient::~RemoteClient()
+{
+	disconnect();
+}
+
+bool RemoteClient::connect(const std::string& path)
+{
+	disconnect();
+	const sockaddr_un addr = socketAddress(path);
+	if ((fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0)
+		return false;
+	if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+		disconnect();
+		return false;
+	}
+	return true;
+}
+
+void RemoteClient::disconnect(void)
+{
+	if (fd >= 0) {
+		close(fd);
+		fd = -1;
+	}
+}
+
+void RemoteClient::transact(RemoteRequest& req, RemoteResponse& resp)
+{
+	req.magic = REMOTE_MAGIC;
+	req.seq = ++seq;
+	if (send(fd, &req, sizeof(req), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(req)))
+		throw make_exception("Socket Exception ", errno);
+	const ssize_t len = recv(fd, &resp, sizeof(resp), 0);
+	if (len < 0)
+		throw make_exception("Socket Exception ", errno);
+	if (len != static_cast<ssize_t>(sizeof(resp)) || resp.seq != req.seq)
+		throw make_exception("Invalid response from the GPIO server!");
+	if (resp.status != RemoteStatus::OK)
+		throw make_exception("Request failed with status ", static_cast<uint32_t>(resp.status));
+}
+
+void RemoteClient::write(const PinSet& high, const PinSet& low)
+{
+	RemoteRequest req;
+	RemoteResponse resp;
+	req.write(high, low);
+	transact(req, resp);
+}
+
+PinLevels RemoteClient::readAll(void)
+{
+	RemoteRequest req;
+	RemoteResponse resp;
+	const uint32_t op = req.read();
+	transact(req, resp);
+	return PinLevels{ resp.values[op] };
+}
+
+void RemoteClient::pinMode(unsigned int pin, PIN_MODE mode)
+{
+	RemoteRequest req;
+	RemoteResponse resp;
+	req.mode(pin, mode);
+	transact(req, resp);
+}
+
+PinSet RemoteClient::takeEvents(const PinSet& pins)
+{
+	RemoteRequest req;
+	RemoteResponse resp;
+	const uint32_t op = req.takeEvents(pins);
+	transact(req, resp);
+	return RemoteRequest::toPins(resp.values[op]);
+}
@@ -0,0 +1,56 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "softpwm.h"
+
+#include <algorithm>
+
+using namespace rpigpio;
+
+void PwmSchedule::build(const PinSet& channels, const uint32_t* duties, uint32_t resolution)
+{
+	on = off = PinSet{};
+	steps.clear();
+
+	for (unsigned int pin = 0; pin < PIN_COUNT; ++pin) {
+		if (!channels.contains(pin)) continue;
+
+		const uint32_t duty = duties[pin];
+		if (duty == 0) {
+			off.add(pin);
+			continue;
+		}
+		on.add(pin);
+		if (duty >= resolution) continue;
+
+		// one step per distinct duty cycle
+		auto it = std::lower_bound(steps.begin(), steps.end(), duty, [](const Step& step, uint32_t tick) {
+			return step.tick < tick;
+		});
+		if (it == steps.end() || it->tick != duty)
+			it = steps.insert(it, Step{ duty, PinSet{} });
+		it->clr.add(pin);
+	}
+}
@@ -0,0 +1,65 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "spi.h"
+
+#include <make_exception.hpp>
+
+using namespace rpigpio;
+
+SpiFrame& SpiFrame::set(unsigned int pin, bool level)
+{
+	uint32_t& mask = pin < 32 ? (level ? set0 : clr0) : (level ? set1 : clr1);
+	mask |= 1u << (pin % 32);
+	return *this;
+}
+
+SpiFrames::SpiFrames(const SpiConfig& config)
+{
+	const unsigned int pins[]{ config.cs, config.sclk, config.mosi };
+	for (unsigned int i = 0; i < 3; ++i) {
+		if (pins[i] >= PIN_COUNT) throw make_exception("Invalid SPI pin: ", pins[i]);
+		for (unsigned int j = 0; j < i; ++j)
+			if (pins[i] == pins[j]) throw make_exception("SPI pin used twice: ", pins[i]);
+	}
+	if (config.miso != SPI_NO_PIN && (config.miso >= PIN_COUNT || config.miso == config.cs || config.miso == config.sclk || config.miso == config.mosi))
+		throw make_exception("Invalid SPI MISO pin: ", config.miso);
+	if (config.mode > 3) throw make_exception("Invalid SPI mode: ", config.mode);
+
+	const bool idle_level = (config.mode >> 1) & 1;    // CPOL
+	const bool cpha = config.mode & 1;
+	for (unsigned int b = 0; b < 2; ++b) {
+		// CPHA 0: setup with the clock idle, sample on the leading edge
+		// CPHA 1: setup on the leading edge, sample on the trailing edge
+		bit[b][0] = SpiFrame{}.set(config.sclk, cpha ? !idle_level : idle_level).set(config.mosi, b);
+		bit[b][1] = SpiFrame{}.set(config.sclk, cpha ? idle_level : !idle_level);
+	}
+	select = SpiFrame{}.set(config.sclk, idle_level).set(config.cs, false);
+	idle = SpiFrame{}.set(config.sclk, idle_level);
+	deselect = SpiFrame{}.set(config.cs, true);
+	bank0 = config.cs < 32 || config.sclk < 32 || config.mosi < 32;
+	bank1 = config.cs >= 32 || config.sclk >= 32 || config.mosi >= 32;
+	half_period = config.clock_hz ? 500000000ull / config.clock_hz : 0;
+}
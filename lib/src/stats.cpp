@@ -0,0 +1,159 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "stats.h"
+#include "clock.h"
+
+#include <iomanip>
+
+using namespace rpigpio;
+
+namespace rpigpio::stats {
+	RegisterCounters registers[REGISTER_COUNT];
+	MethodCounters methods[METHOD_COUNT];
+	std::atomic<uint64_t> pins[PIN_COUNT]{};
+
+	const char* methodName(Method method)
+	{
+		static constexpr const char* names[METHOD_COUNT]{
+			"connect", "disconnect", "pinMode", "getMode", "pinUp", "pinDown", "pinLev", "readAll",
+			"digitalWrite", "writeMask", "digitalRead", "edgeDetect", "readEvents", "clearEvents", "reset",
+			"pinPull",
+		};
+		const auto index = static_cast<unsigned int>(method);
+		return index < METHOD_COUNT ? names[index] : "?";
+	}
+
+	const char* registerName(uint32_t off)
+	{
+		static constexpr const char* names[REGISTER_COUNT]{
+			"GPFSEL0", "GPFSEL1", "GPFSEL2", "GPFSEL3", "GPFSEL4", "GPFSEL5", nullptr,
+			"GPSET0", "GPSET1", nullptr,
+			"GPCLR0", "GPCLR1", nullptr,
+			"GPLEV0", "GPLEV1", nullptr,
+			"GPEDS0", "GPEDS1", nullptr,
+			"GPREN0", "GPREN1", nullptr,
+			"GPFEN0", "GPFEN1", nullptr,
+			"GPHEN0", "GPHEN1", nullptr,
+			"GPLEN0", "GPLEN1", nullptr,
+			"GPAREN0", "GPAREN1", nullptr,
+			"GPAFEN0", "GPAFEN1", nullptr,
+			"GPPUD", "GPPUDCLK0", "GPPUDCLK1",
+		};
+		return off / 4 < REGISTER_COUNT ? names[off / 4] : nullptr;
+	}
+
+	void record(Method method, uint64_t ns)
+	{
+		auto& m = methods[static_cast<unsigned int>(method)];
+		m.calls.fetch_add(1, std::memory_order_relaxed);
+		m.total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+		unsigned int bucket = 0;
+		while (bucket + 1 < BUCKETS && (ns >> (bucket + 1)) != 0)
+			++bucket;
+		m.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Scope::Scope(Method method_p) : method{ method_p }, start{ monotonicNow() } {}
+
+	Scope::~Scope()
+	{
+		record(method, monotonicNow() - start);
+	}
+
+	uint64_t Snapshot::Method::percentile(double p) const
+	{
+		if (calls == 0) return 0;
+		const auto target = static_cast<uint64_t>(static_cast<double>(calls) * p / 100.0);
+		uint64_t seen = 0;
+		for (unsigned int bucket = 0; bucket < BUCKETS; ++bucket) {
+			seen += histogram[bucket];
+			if (seen > target) return (2ull << bucket) - 1;
+		}
+		return (2ull << (BUCKETS - 1)) - 1;
+	}
+
+	Snapshot snapshot()
+	{
+		Snapshot snap;
+		for (unsigned int i = 0; i < REGISTER_COUNT; ++i) {
+			snap.registers[i].loads = registers[i].loads.load(std::memory_order_relaxed);
+			snap.registers[i].stores = registers[i].stores.load(std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0; i < METHOD_COUNT; ++i) {
+			snap.methods[i].calls = methods[i].calls.load(std::memory_order_relaxed);
+			snap.methods[i].total_ns = methods[i].total_ns.load(std::memory_order_relaxed);
+			for (unsigned int b = 0; b < BUCKETS; ++b)
+				snap.methods[i].histogram[b] = methods[i].histogram[b].load(std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0; i < PIN_COUNT; ++i)
+			snap.pins[i] = pins[i].load(std::memory_order_relaxed);
+		return snap;
+	}
+
+	void reset()
+	{
+		for (auto& r : registers) {
+			r.loads.store(0, std::memory_order_relaxed);
+			r.stores.store(0, std::memory_order_relaxed);
+		}
+		for (auto& m : methods) {
+			m.calls.store(0, std::memory_order_relaxed);
+			m.total_ns.store(0, std::memory_order_relaxed);
+			for (auto& b : m.histogram)
+				b.store(0, std::memory_order_relaxed);
+		}
+		for (auto& p : pins)
+			p.store(0, std::memory_order_relaxed);
+	}
+
+	std::ostream& operator<<(std::ostream& os, const Snapshot& snap)
+	{
+		if (!enabled)
+			return os << "Statistics are disabled, rebuild with RPI_GPIO_ENABLE_STATS.\n";
+
+		os << "REGISTERS:\n" << "  " << std::left << std::setw(12) << "Register" << std::right << std::setw(14) << "Loads" << std::setw(14) << "Stores" << '\n';
+		for (unsigned int i = 0; i < REGISTER_COUNT; ++i) {
+			const auto& r = snap.registers[i];
+			if (r.loads || r.stores)
+				os << "  " << std::left << std::setw(12) << (registerName(i * 4) ? registerName(i * 4) : "?") << std::right << std::setw(14) << r.loads << std::setw(14) << r.stores << '\n';
+		}
+
+		os << "METHODS:\n" << "  " << std::left << std::setw(14) << "Method" << std::right << std::setw(12) << "Calls" << std::setw(12) << "Mean ns" << std::setw(12) << "p50 ns" << std::setw(12) << "p99 ns" << '\n';
+		for (unsigned int i = 0; i < METHOD_COUNT; ++i) {
+			const auto& m = snap.methods[i];
+			if (m.calls)
+				os << "  " << std::left << std::setw(14) << methodName(static_cast<Method>(i)) << std::right << std::setw(12) << m.calls
+				<< std::setw(12) << m.total_ns / m.calls << std::setw(12) << m.percentile(50) << std::setw(12) << m.percentile(99) << '\n';
+		}
+
+		os << "PINS:\n";
+		for (unsigned int i = 0; i < PIN_COUNT; ++i)
+			if (snap.pins[i])
+				os << "  " << std::left << std::setw(14) << i << std::right << std::setw(12) << snap.pins[i] << '\n';
+		return os;
+	}
+}
@@ -0,0 +1,186 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "trace.h"
+#include "gpio.h"
+
+#include <make_exception.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+using namespace rpigpio;
+
+/** TraceRecorder **/
+
+void TraceRecorder::save(const std::string& path) const
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+		throw make_exception("I/O Exception ", errno);
+
+	const size_t count = size();
+	const TraceHeader header{ TRACE_MAGIC, TRACE_VERSION, count, dropped(), origin };
+	const bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(records.data(), sizeof(TraceRecord), count, file) == count;
+	if (fclose(file) != 0 || !ok)
+		throw make_exception("I/O Exception ", errno);
+}
+
+/** TraceReader **/
+
+TraceReader::TraceReader(const std::string& path)
+{
+	if (!(file = fopen(path.c_str(), "rb")))
+		throw make_exception("I/O Exception ", errno);
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+		fclose(file);
+		throw make_exception("Invalid trace file: ", path);
+	}
+	remaining = header.count;
+}
+
+TraceReader::~TraceReader()
+{
+	fclose(file);
+}
+
+size_t TraceReader::read(TraceRecord* out, size_t max)
+{
+	if (max > remaining) max = static_cast<size_t>(remaining);
+	const size_t n = fread(out, sizeof(TraceRecord), max, file);
+	remaining = n == max ? remaining - n : 0;
+	return n;
+}
+
+/** Trace comparison **/
+
+bool TraceState::sameOutput(const TraceState& o) const
+{
+	for (unsigned int rnum = 0; rnum < 6; ++rnum)
+		if (fsel[rnum] != o.fsel[rnum]) return false;
+	return levels == o.levels;
+}
+
+namespace {
+	/**
+	 * Reduces a trace to its sequence of output states
+	 */
+	class StateStream {
+	private:
+		TraceReader reader;
+		TraceRecord buffer[4096];
+		size_t size{ 0 };
+		size_t index{ 0 };
+		uint64_t window;
+		TraceState state;
+
+		const TraceRecord* peek(void)
+		{
+			if (index == size) {
+				size = reader.read(buffer, 4096);
+				index = 0;
+			}
+			return index < size ? &buffer[index] : nullptr;
+		}
+
+		static void apply(TraceState& s, const TraceRecord& r)
+		{
+			switch (r.off) {
+			case GPSET0: s.levels |= r.value; break;
+			case GPSET1: s.levels |= static_cast<uint64_t>(r.value) << 32; break;
+			case GPCLR0: s.levels &= ~static_cast<uint64_t>(r.value); break;
+			case GPCLR1: s.levels &= ~(static_cast<uint64_t>(r.value) << 32); break;
+			default:
+				if (r.off <= GPFSEL[5] && r.off % 4 == 0)
+					s.fsel[r.off / 4] = r.value;
+				break;
+			}
+		}
+
+	public:
+		StateStream(const std::string& path, uint64_t window_p) : reader{ path }, window{ window_p } {}
+
+		/**
+		 * @param out next output state
+		 * @return false at the end of the trace
+		 */
+		bool next(TraceState& out)
+		{
+			for (const TraceRecord* r; (r = peek()) != nullptr;) {
+				const TraceState previous = state;
+				const uint64_t start = r->time;
+				apply(state, *r);
+				++index;
+				while ((r = peek()) != nullptr && r->time - start < window) {
+					apply(state, *r);
+					++index;
+				}
+
+				if (!state.sameOutput(previous)) {
+					state.time = start;
+					out = state;
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+}
+
+TraceDiff rpigpio::diffTraces(const std::string& path_a, const std::string& path_b, uint64_t merge_window, uint64_t tolerance)
+{
+	TraceDiff diff;
+	StateStream a{ path_a, merge_window }, b{ path_b, merge_window };
+	TraceState sa, sb;
+	uint64_t origin_a = 0, origin_b = 0;
+
+	while (true) {
+		const bool has_a = a.next(sa), has_b = b.next(sb);
+		if (!has_a && !has_b) break;
+		if (has_a) ++diff.states_a;
+		if (has_b) ++diff.states_b;
+
+		// times are compared relative to the first change of each trace
+		if (diff.states_a == 1 && has_a) origin_a = sa.time;
+		if (diff.states_b == 1 && has_b) origin_b = sb.time;
+
+		if (has_a && has_b && sa.sameOutput(sb)) {
+			const int64_t skew = static_cast<int64_t>((sb.time - origin_b) - (sa.time - origin_a));
+			if (static_cast<uint64_t>(std::llabs(skew)) > tolerance) ++diff.late;
+			if (std::llabs(skew) > std::llabs(diff.max_skew)) diff.max_skew = skew;
+			continue;
+		}
+
+		++diff.mismatches;
+		if (!diff.found) {
+			diff.found = true;
+			diff.first_index = std::max(diff.states_a, diff.states_b) - 1;
+			if (has_a) diff.first_a = sa;
+			if (has_b) diff.first_b = sb;
+		}
+	}
+	return diff;
+}
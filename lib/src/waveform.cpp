@@ -0,0 +1,122 @@
+/*
+
+MIT License
+
+Copyright (c) 2018 Guillaume Bauer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "waveform.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cerrno>
+
+#include <time.h>
+
+using namespace rpigpio;
+
+/** Waveform **/
+
+Waveform& Waveform::add(uint64_t time, unsigned int pin, bool lev)
+{
+	if (lev)
+		return add(time, PinSet{}.add(pin), PinSet{});
+	else
+		return add(time, PinSet{}, PinSet{}.add(pin));
+}
+
+Waveform& Waveform::add(uint64_t time, const PinSet& high, const PinSet& low)
+{
+	transitions.push_back({ time, high, low });
+	return *this;
+}
+
+void Waveform::clear()
+{
+	transitions.clear();
+	compiled.clear();
+}
+
+const std::vector<WaveFrame>& Waveform::compile()
+{
+	std::stable_sort(transitions.begin(), transitions.end(), [](const Transition& a, const Transition& b) {
+		return a.time < b.time;
+	});
+
+	compiled.clear();
+	for (const auto& t : transitions) {
+		if (compiled.empty() || compiled.back().deadline != t.time)
+			compiled.push_back({ t.time, PinSet{}, PinSet{} });
+
+		auto& frame = compiled.back();
+		// later transitions of the same pin win
+		frame.set = (frame.set & ~t.low) | t.high;
+		frame.clr = (frame.clr & ~t.high) | t.low;
+	}
+
+	return compiled;
+}
+
+/** PlaybackStats **/
+
+PlaybackStats PlaybackStats::compute(std::vector<int64_t>& deviations)
+{
+	PlaybackStats stats;
+	if (deviations.empty()) return stats;
+
+	std::sort(deviations.begin(), deviations.end());
+	stats.frames = deviations.size();
+	stats.min = deviations.front();
+	stats.max = deviations.back();
+	stats.mean = static_cast<double>(std::accumulate(deviations.begin(), deviations.end(), int64_t{ 0 })) / static_cast<double>(deviations.size());
+	stats.p50 = deviations[deviations.size() / 2];
+	stats.p99 = deviations[std::min(deviations.size() - 1, deviations.size() * 99 / 100)];
+	return stats;
+}
+
+/** WaveformPlayer **/
+
+uint64_t WaveformPlayer::calibrate(unsigned int samples)
+{
+	std::vector<int64_t> latencies(samples);
+	for (auto& latency : latencies) {
+		const uint64_t deadline{ monotonicNow() + 100000 };
+		const timespec ts{ static_cast<time_t>(deadline / 1000000000ull), static_cast<long>(deadline % 1000000000ull) };
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+		latency = static_cast<int64_t>(monotonicNow() - deadline);
+	}
+
+	// cover the 99th percentile with a 25% margin
+	const auto stats{ PlaybackStats::compute(latencies) };
+	spin_window = static_cast<uint64_t>(std::max<int64_t>(stats.p99, 0)) * 5 / 4;
+	return spin_window;
+}
+
+void WaveformPlayer::waitUntil(uint64_t deadline) const
+{
+	if (deadline > spin_window && monotonicNow() < deadline - spin_window) {
+		const uint64_t wake{ deadline - spin_window };
+		const timespec ts{ static_cast<time_t>(wake / 1000000000ull), static_cast<long>(wake % 1000000000ull) };
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+	}
+
+	while (monotonicNow() < deadline) {}
+}
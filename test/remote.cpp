@@ -0,0 +1,180 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <RPI-GPIO.h>
+
+using namespace rpigpio;
+
+static unsigned int failures{ 0 };
+
+#define CHECK(cond) do { if (!(cond)) { std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; ++failures; } } while (0)
+
+/**
+ * Raw connection to the server, to send requests RemoteClient would refuse to build
+ */
+struct RawClient {
+	int fd{ -1 };
+
+	explicit RawClient(const std::string& path)
+	{
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+		if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+			throw std::runtime_error{ "Failed to connect to '" + path + "'!" };
+	}
+	~RawClient() { close(fd); }
+
+	bool transact(const RemoteRequest& req, RemoteResponse& resp) const
+	{
+		return send(fd, &req, sizeof(req), MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(req))
+			&& recv(fd, &resp, sizeof(resp), 0) == static_cast<ssize_t>(sizeof(resp));
+	}
+};
+
+void TestRoundTrip(const EmuMem& mem, const EmuGPIO& gpio, const std::string& path)
+{
+	RemoteClient client;
+	CHECK(client.connect(path));
+
+	client.pinMode(17, PIN_MODE::OUTPUT);
+	CHECK(gpio.getMode(17) == PIN_MODE::OUTPUT);
+	gpio.pinMode(ModeConfig{}.set(27, PIN_MODE::OUTPUT).set(40, PIN_MODE::OUTPUT));
+
+	gpio.write({ 27 }, {});
+	client.write({ 17, 40 }, { 27 });
+	const PinLevels levels{ gpio.readAll() };
+	CHECK(levels[17] && levels[40] && !levels[27]);
+	CHECK(client.readAll() == levels);
+
+	// only the harvested events are cleared
+	gpio.edgeDetect({ 5, 22, 41 }, EDGE_DETECT::RISING);
+	mem.emulator->drive({ 5, 22, 41 }, { 5, 22, 41 });
+	CHECK(gpio.readEvents() == (PinSet{ 5, 22, 41 }));
+	CHECK(client.takeEvents({ 5, 6, 41 }) == (PinSet{ 5, 41 }));
+	CHECK(gpio.readEvents() == (PinSet{ 22 }));
+	CHECK(client.takeEvents({ 5, 41 }) == PinSet{});
+
+	// several ops in one request, in order
+	RemoteRequest req;
+	RemoteResponse resp;
+	req.mode(22, PIN_MODE::ALT2);
+	const uint32_t read{ req.read() };
+	req.write({}, { 17 });
+	client.transact(req, resp);
+	CHECK(resp.status == RemoteStatus::OK);
+	CHECK(resp.count == 3);
+	// the read happened before the clear
+	CHECK(PinLevels{ resp.values[read] }[17]);
+	CHECK(!gpio.readAll()[17]);
+	CHECK(gpio.getMode(22) == PIN_MODE::ALT2);
+
+	// a request holds at most REMOTE_MAX_OPS ops
+	RemoteRequest full;
+	for (uint32_t i{ 0 }; i < REMOTE_MAX_OPS; ++i)
+		full.read();
+	bool thrown{ false };
+	try {
+		full.read();
+	} catch (const std::length_error&) {
+		thrown = true;
+	}
+	CHECK(thrown);
+	CHECK(full.count == REMOTE_MAX_OPS);
+}
+
+void TestErrors(const std::string& path)
+{
+	const RawClient raw{ path };
+	RemoteResponse resp;
+
+	// responses never carry values of earlier requests, the round trip left pins HIGH
+	RemoteRequest reads;
+	for (uint32_t i{ 0 }; i < REMOTE_MAX_OPS; ++i)
+		reads.read();
+	CHECK(raw.transact(reads, resp));
+	CHECK(resp.status == RemoteStatus::OK && resp.count == REMOTE_MAX_OPS);
+	CHECK(resp.values[REMOTE_MAX_OPS - 1] != 0);
+
+	RemoteRequest req;
+	req.magic = 0x12345678;
+	req.seq = 7;
+	req.read();
+	CHECK(raw.transact(req, resp));
+	CHECK(resp.seq == 7);
+	CHECK(resp.status == RemoteStatus::BAD_MAGIC);
+	CHECK(resp.count == 0);
+	for (const uint64_t value : resp.values)
+		CHECK(value == 0);
+
+	req = RemoteRequest{};
+	req.count = REMOTE_MAX_OPS + 1;
+	CHECK(raw.transact(req, resp));
+	CHECK(resp.status == RemoteStatus::BAD_COUNT);
+	for (const uint64_t value : resp.values)
+		CHECK(value == 0);
+
+	req = RemoteRequest{};
+	req.read();
+	req.ops[req.read()].code = static_cast<RemoteOpCode>(42);
+	CHECK(raw.transact(req, resp));
+	CHECK(resp.status == RemoteStatus::BAD_OP);
+	CHECK(resp.count == 1);
+	for (uint32_t i{ 1 }; i < REMOTE_MAX_OPS; ++i)
+		CHECK(resp.values[i] == 0);
+
+	req = RemoteRequest{};
+	req.mode(PIN_COUNT, PIN_MODE::OUTPUT);
+	CHECK(raw.transact(req, resp));
+	CHECK(resp.status == RemoteStatus::BAD_OP);
+	CHECK(resp.count == 0);
+
+	req = RemoteRequest{};
+	req.mode(17, PIN_MODE{ 0b1000 });
+	CHECK(raw.transact(req, resp));
+	CHECK(resp.status == RemoteStatus::BAD_OP);
+}
+
+int main()
+{
+	try {
+		const EmuMem mem;
+		EmuGPIO gpio{ mem };
+		gpio.connect();
+
+		const std::string path{ "/tmp/rpigpio-remotetest-" + std::to_string(getpid()) + ".sock" };
+		RemoteServer server{ path };
+		std::atomic<bool> stop{ false };
+		std::thread thread{ [&] { server.serve(gpio, stop); } };
+
+		try {
+			TestRoundTrip(mem, gpio, path);
+			TestErrors(path);
+		} catch (...) {
+			stop.store(true);
+			thread.join();
+			throw;
+		}
+		stop.store(true);
+		thread.join();
+	} catch (const std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+
+	if (failures) {
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All remote tests passed" << std::endl;
+	return 0;
+}
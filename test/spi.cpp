@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <RPI-GPIO.h>
+
+using namespace rpigpio;
+
+static unsigned int failures{ 0 };
+
+#define CHECK(cond) do { if (!(cond)) { std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; ++failures; } } while (0)
+
+// the bit sequences are decoded from a trace of the register writes, see CMakeLists.txt
+static_assert(TRACE_ENABLED, "spitest must be built against gpiolib with RPI_GPIO_TRACE");
+
+constexpr unsigned int CS{ 8 }, SCLK{ 11 }, MOSI{ 10 }, MISO{ 9 };
+
+/**
+ * Decodes the MOSI bits of a recorded transfer, sampled on the edges where the mode samples
+ * @param trace recorded register writes
+ * @param mode SPI mode
+ * @param deselected set to false if a clock edge happened while CS was released
+ * @return sampled bits, in order
+ */
+std::vector<bool> DecodeMosi(const TraceRecorder& trace, const unsigned int mode, bool& deselected)
+{
+	const bool idle{ ((mode >> 1) & 1) != 0 };
+	const bool sample_leading{ (mode & 1) == 0 };
+	bool cs{ true }, sclk{ idle }, mosi{ false };
+	std::vector<bool> bits;
+	for (size_t i{ 0 }; i < trace.size(); ++i) {
+		const TraceRecord& rec{ trace.data()[i] };
+		if (rec.off != GPSET0 && rec.off != GPCLR0) continue;
+		const bool level{ rec.off == GPSET0 };
+		const bool prev_sclk{ sclk };
+		if (rec.value & 1u << CS) cs = level;
+		if (rec.value & 1u << MOSI) mosi = level;
+		if (rec.value & 1u << SCLK) sclk = level;
+		if (sclk == prev_sclk) continue;
+
+		if (cs) deselected = false;
+		const bool leading{ prev_sclk == idle };
+		if (leading == sample_leading) bits.push_back(mosi);
+	}
+	return bits;
+}
+
+void TestBitSequence(const unsigned int mode, const bool lsb_first)
+{
+	EmuMem mem;
+	EmuGPIO gpio{ mem };
+	gpio.connect();
+	const SpiMaster<EmuMem> spi{ gpio, SpiConfig{ CS, SCLK, MOSI, MISO, mode, 0, lsb_first } };
+	CHECK(gpio.pinLev(CS) == 1);
+	CHECK(gpio.pinLev(SCLK) == ((mode >> 1) & 1));
+
+	const uint8_t tx[]{ 0xA5, 0x01, 0x80, 0xFF, 0x00, 0x3C };
+	TraceRecorder trace{ 4096 };
+	gpio.setRecorder(&trace);
+	spi.write(tx, sizeof(tx));
+	gpio.setRecorder(nullptr);
+
+	bool selected{ true };
+	const std::vector<bool> bits{ DecodeMosi(trace, mode, selected) };
+	CHECK(selected);
+	CHECK(bits.size() == sizeof(tx) * 8);
+	for (size_t i{ 0 }; i < bits.size() && i < sizeof(tx) * 8; ++i) {
+		const unsigned int shift{ lsb_first ? static_cast<unsigned int>(i % 8) : 7 - static_cast<unsigned int>(i % 8) };
+		CHECK(bits[i] == (((tx[i / 8] >> shift) & 1) != 0));
+	}
+	CHECK(gpio.pinLev(CS) == 1);
+	CHECK(gpio.pinLev(SCLK) == ((mode >> 1) & 1));
+}
+
+void TestLoopback(const unsigned int mode, const bool lsb_first)
+{
+	EmuMem mem;
+	EmuGPIO gpio{ mem };
+	gpio.connect();
+	mem.emulator->loopback(MOSI, MISO);
+	const SpiMaster<EmuMem> spi{ gpio, SpiConfig{ CS, SCLK, MOSI, MISO, mode, 0, lsb_first } };
+
+	uint8_t tx[256], rx[256]{};
+	for (unsigned int i{ 0 }; i < 256; ++i)
+		tx[i] = static_cast<uint8_t>(i * 37 + 11);
+	spi.transfer(tx, rx, sizeof(tx));
+	CHECK(std::memcmp(tx, rx, sizeof(tx)) == 0);
+}
+
+void TestPacing()
+{
+	EmuGPIO gpio{};
+	gpio.connect();
+	const SpiMaster<EmuMem> spi{ gpio, SpiConfig{ CS, SCLK, MOSI, SPI_NO_PIN, 0, 100000 } };
+
+	const uint8_t tx[10]{};
+	const auto begin{ std::chrono::steady_clock::now() };
+	spi.write(tx, sizeof(tx));
+	// 80 bits at 100kHz
+	CHECK(std::chrono::steady_clock::now() - begin >= std::chrono::microseconds{ 800 });
+}
+
+void TestInvalidConfig()
+{
+	EmuGPIO gpio{};
+	gpio.connect();
+	for (const SpiConfig& config : { SpiConfig{ CS, CS, MOSI }, SpiConfig{ CS, SCLK, PIN_COUNT }, SpiConfig{ CS, SCLK, MOSI, MOSI }, SpiConfig{ CS, SCLK, MOSI, MISO, 4 } }) {
+		bool thrown{ false };
+		try {
+			const SpiMaster<EmuMem> spi{ gpio, config };
+		} catch (const std::exception&) {
+			thrown = true;
+		}
+		CHECK(thrown);
+	}
+}
+
+int main()
+{
+	try {
+		for (unsigned int mode{ 0 }; mode < 4; ++mode) {
+			for (const bool lsb_first : { false, true }) {
+				TestBitSequence(mode, lsb_first);
+				TestLoopback(mode, lsb_first);
+			}
+		}
+		TestPacing();
+		TestInvalidConfig();
+	} catch (const std::exception& ex) {
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+
+	if (failures) {
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All SPI tests passed" << std::endl;
+	return 0;
+}